@@ -0,0 +1,46 @@
+#ifndef _archive_h_
+#define _archive_h_
+
+
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include "binaryFile.hpp"
+#include "stringTable.hpp"
+
+#include <iostream>
+using namespace std;
+
+
+// An object file stored in an archive:
+struct ArchiveMember {
+  string name;
+  uint offset;              // Where the object file starts in the archive.
+  uint size;
+  vector<string> globals;   // Global symbols the object file defines.
+  bool extracted = false;   // Already given to the linker.
+};
+
+// A library of object files: (archiver's output, '.a')
+//  The index of members and the global symbols they define comes first, so the linker can pick members without reading them,
+//  the members' object files follow it unchanged.
+class Archive {
+public:
+  string fileName;
+  vector<ArchiveMember> members;
+  unordered_map<uint, uint> symbolIndex;  // symName -> index of the first member that defines it
+
+  // Size in bytes of the index, so the members' offsets are known before it's written:
+  uint indexSize();
+
+  // Binary file support: (of the index)
+  void bWriteIndex(std::ofstream& file);
+  // Returns -1 (and prints the reason) if the file isn't an archive of the current version:
+  int bReadIndex(std::ifstream& file);
+
+  // Fills symbolIndex from members' globals:
+  void buildSymbolIndex();
+};
+
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _archiver_h_
+#define _archiver_h_
+
+
+#include <algorithm>
+#include "string.h"
+#include "../inc/symbolTable.hpp"
+#include "../inc/archive.hpp"
+
+#include <iostream>
+using namespace std;
+
+
+// Remember the archive's name and the object files that go into it:
+int processCommandLineArguments(int argc, char* argv[]);
+
+// Reads an object file and the names of the global symbols it defines:
+int readMember(string fileName, vector<char>& content, vector<string>& globals);
+
+// Writes the index followed by the members' object files:
+int writeArchive();
+
+
+#endif
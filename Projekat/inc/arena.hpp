@@ -0,0 +1,40 @@
+#ifndef _arena_h_
+#define _arena_h_
+
+
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Bump allocator: objects are carved out of big blocks one after another and are all freed at once by release().
+//  (no destructors are run, so it's only for plain structs and strings)
+class Arena {
+  std::vector<char*> blocks;
+  std::vector<char*> bigBlocks;  // Requests bigger than a block get a block of their own.
+  char* cur = nullptr;  // Free space left in the last block.
+  size_t left = 0;
+
+  static const size_t blockSize = 1 << 16;
+  static const size_t alignment = 8;
+
+public:
+  Arena() {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena() { release(); }
+
+  void* allocate(size_t size);
+  template<typename T> T* create() { return (T*)allocate(sizeof(T)); }
+
+  // Copies len chars into the arena and terminates them with '\0':
+  char* copyString(const char* text, size_t len);
+
+  void release();
+
+  // Frees everything but keeps the first block for reuse:
+  void reset();
+};
+
+
+#endif
@@ -4,9 +4,14 @@
 
 #include <unordered_map>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <sys/stat.h>  // For creating the batch mode's output directory.
+#include <errno.h>
 
 #include "string.h"
 #include "parserHelper.hpp"
+#include "stringTable.hpp"
 #include "symbolTable.hpp"
 #include "sectionTable.hpp"
 #include "relocationTables.hpp"
@@ -15,24 +20,69 @@
 using namespace std;
 
 
-// Funs used in assembler's first cycle:
-int processCommandLabels(lab* labels);
-int processCommandSymbol(arg* a, command* cmnd);
-int processCommandLiteral(arg* a, command* cmnd);
+// Helper funs used in second cycle:
+bool isGPR(char* reg);
+bool isCSR(char* reg);
+bool isReg(char* reg);
+uint getRegId(char* reg);
 
-void updateLocCounter(command* cmnd);
+// Machine instruction word 0xOMABCDDD: (opcode, mode, registers A, B, C and a 12 bit displacement)
+uint encodeInstruction(uint op, uint mode, uint regA, uint regB, uint regC, uint disp);
 
-int firstCycle();
 
+// Assembles one '.s' file: (all of its state is in here, so that one process can assemble many files)
+class Assembler {
+  StringTable stringTable;  // Names used by this file's tables. (hides the global stringTable)
+  SymbolTable symbolTable;
+  SectionTable sectionTable;
+  RelocationTables relocationTables;
 
-// Funs used in assembler's second cycle:
-bool isGPR(char* reg);
-bool isCSR(char* reg);
-bool isReg(char* reg);
-char getRegId(char* reg);
-string intToHex(uint num, uint hexLen);
+  uint locCounter = 0;
+  Section curSection = Section(undId);
+  RelocationTable curRelTable;
+
+  // Option '--single-pass': every command is assembled as soon as it's parsed, the parsed commands aren't kept.
+  //  Pool isn't placed until its section ends, so instructions and relocations that address it are patched then.
+  bool singlePassOption;
+  vector<pair<uint, uint>> poolFixups;   // <location of a machineInstr, index of the pool entry it addresses> in the current section.
+
+
+  // Funs used in assembler's first cycle:
+  int processCommandLabels(lab* labels);
+  int processCommandSymbol(arg* a, command* cmnd);
+  int processCommandLiteral(arg* a, command* cmnd);
+
+  void updateLocCounter(command* cmnd);
+
+  int processCommand(command* cmnd);
+  void endSection();
+
+  int firstCycle(command* commands);
+
+
+  // Funs used in assembler's second cycle:
+  uint poolDisp(uint location);
+  void addPoolRelocation(uint sym, uint location);
+
+  int assembleCommand(command* cmnd);
+  int secondCycle(command* commands);
+
+
+  // Option '--single-pass': (commands are assembled as they're parsed)
+  int assembleParsedCommand(command* cmnd);
+
+public:
+  Assembler(bool singlePass = false) { singlePassOption = singlePass; }
+
+  // Assembles inputPath into the object file outputPath (and its textual form outputPath.txt):
+  int assemble(const string& inputPath, const string& outputPath);
+};
+
+
+int processCommandLineArguments(int argc, char* argv[]);
 
-int secondCycle();
+// Batch mode: many input files assembled in one process, on a pool of threads ('-j' option)
+int assembleBatch(string prefix);
 
 
-#endif
\ No newline at end of file
+#endif
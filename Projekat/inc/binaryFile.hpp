@@ -0,0 +1,41 @@
+#ifndef _binary_file_h_
+#define _binary_file_h_
+
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include "string.h"
+
+#include <iostream>
+using namespace std;
+
+
+// Every binary file starts with a magic number and the format version, so that files of an older format are detected:
+const uint objectFileMagic = 0x4A424F41;      // "AOBJ" - assembler's output.
+const uint executableFileMagic = 0x45584541;  // "AEXE" - linker's output.
+const uint linkCacheMagic = 0x4B4E4C41;       // "ALNK" - linker's state for incremental linking.
+const uint archiveMagic = 0x43524141;         // "AARC" - archiver's output, a library of object files.
+const uint binaryFileVersion = 3;  // 2 - object files carry a string table, names in their tables are ids into it.
+                                   // 3 - sections list their machine instructions that address the pool.
+const uint binaryFileHeaderSize = 2 * sizeof(uint);
+
+void bWriteHeader(ofstream& file, uint magic);
+// Returns -1 (and prints the reason) if the file doesn't start with the given magic number and the current version:
+int bCheckHeader(ifstream& file, uint magic, string fileName);
+int bCheckHeader(const char* image, unsigned long imageSize, uint magic, string fileName);
+
+
+// Values are written in the host's byte order, strings and byte vectors are prefixed with their length:
+void bWriteUint(ofstream& file, uint value);
+void bWriteUlong(ofstream& file, ulong value);
+void bWriteString(ofstream& file, const string& s);
+void bWriteBytes(ofstream& file, const vector<char>& bytes);
+
+uint bReadUint(ifstream& file);
+ulong bReadUlong(ifstream& file);
+void bReadString(ifstream& file, string& s);
+void bReadBytes(ifstream& file, vector<char>& bytes);
+
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _devices_h_
+#define _devices_h_
+
+#include "emulator.hpp"
+#include <queue>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <termios.h>  // For reading terminal input without echo and line buffering.
+#include <unistd.h>
+
+
+// Memory mapped device registers:
+const uint termOut = 0xFFFFFF00;  // Writing a character prints it.
+const uint termIn  = 0xFFFFFF04;  // Last character typed, a terminal interrupt is raised for every one.
+const uint timCfg  = 0xFFFFFF10;  // Timer period (index into timerPeriodsMs).
+const uint devicesStart = termOut;
+
+// Interrupt causes:
+const uint timerCause = 2;
+const uint terminalCause = 3;
+
+// Devices run in virtual time, measured by instrCount:
+const ulong virtualInstrsPerMs = 1000;
+const ulong inputPollInstrs = 10 * virtualInstrsPerMs;  // How often typed characters are picked up.
+const ulong timerPeriodsMs[8] = { 500, 1000, 1500, 2000, 5000, 10000, 30000, 60000 };
+
+enum DeviceEventKind {
+  TIMER_EVENT, INPUT_POLL_EVENT
+};
+struct DeviceEvent {
+  ulong when;         // instrCount at which the event is due.
+  DeviceEventKind kind;
+  ulong generation;   // Timer events scheduled before the last tim_cfg write are ignored.
+
+  bool operator>(const DeviceEvent& other) const { return when > other.when; }
+};
+
+// Engines call handleEvents() before executing the next instruction once instrCount reaches this:
+extern ulong eventDeadline;
+
+
+// Schedule the timer, start reading terminal input:
+void devicesInit();
+void devicesFree();
+
+// Fires due events and enters the interrupt handler if an unmasked interrupt is pending:
+void handleEvents();
+
+// Called by writeWord for addresses from devicesStart onwards:
+void deviceWrite(uint address, uint value);
+// Called after every write to csr[status], a pending interrupt might have gotten unmasked:
+void deviceStatusWritten();
+
+
+#endif
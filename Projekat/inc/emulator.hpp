@@ -3,18 +3,77 @@
 
 #include "memoryContent.hpp"  // For writing MemoryContents from linker's output file into the host's memory addresses for emulation.
 #include "sys/mman.h" // For mmap.
+#include <fcntl.h>    // For mapping the input file.
+#include <sys/stat.h>
+#include <unistd.h>
 #include <sstream>    // For intToHex.
 #include <iomanip>    // For intToHex.
+#include <chrono>     // For emulation stats.
+#include "string.h"
 
 
 #include <iostream>
 using namespace std;
 
 
+enum GPR {
+  r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, sp, pc
+};
+enum CSR {
+  status, handler, cause
+};
+enum Engine {
+  REFERENCE, THREADED, JIT
+};
+
+// Emulated processor state and memory:
+extern int gpr[16];
+extern uint csr[3];
+extern char* memory;
+extern ulong instrCount;
+
+
+// Decoded instruction: (operands are split out of the instruction word once, when it's first fetched)
+struct DecodedInstr;
+typedef int (*InstrHandler)(DecodedInstr& di);  // Returns 0 to continue, 1 on HALT, -1 on an unrecognized instruction.
+struct DecodedInstr {
+  InstrHandler handler;
+  unsigned char regA, regB, regC;
+  unsigned short disp;
+};
+
+// Decoded instructions of a single 4KiB page of guest memory, indexed by (pc & pageMask) / 4:
+const uint pageBits = 12;
+const uint pageMask = (1 << pageBits) - 1;
+const uint instrsPerPage = (1 << pageBits) / 4;
+const uint decodedPageCount = 1 << (32 - pageBits);
+struct DecodedPage {
+  DecodedInstr instrs[instrsPerPage];
+};
+
+// Sparse guest memory: (option '-sparse') the top 10 bits of an address pick a SparseTable,
+//  the next 10 a 4KiB page in it. Pages are allocated on the first write to them.
+const uint sparseLevelBits = 10;
+const uint sparseLevelSize = 1 << sparseLevelBits;
+struct SparseTable {
+  char* pages[sparseLevelSize];
+};
+
+
 // Write the linker's memory contents into the memory space used for emulation:
-void initializeMemory(ifstream& in, char* memory);
+int initializeMemory(int fd, const char* image, ulong imageSize);
+// Remember inputFileName and the given options:
+int processCommandLineArguments(int argc, char* argv[]);
 // Allocate memory for emulation and initialize it:
-int prepareMemory(int argc, char* argv[]);
+int prepareMemory();
+void freeMemory();
+
+// Guest memory access:
+char* sparsePage(uint address, bool allocate);
+char* guestByte(uint address);
+void copyToGuest(uint address, const char* src, uint size);
+uint readWord(uint address);
+void writeWord(uint address, uint value);
 
 // Helper funs:
 void pushCSR(int id);
@@ -23,11 +82,19 @@ void popCSR(int id);
 void popGPR(int id);
 string intToHex(uint num, int hexLen);
 
+// Decoded instruction cache:
+void decodeInstr(uint word, DecodedInstr& di);
+DecodedPage& fetchDecodedPage(uint address);
+void invalidateDecoded(uint address);
+void freeDecodeCache();
+
 // Emulate: (execute machine instruction starting from address memory+gpr[pc])
 int emulate();
+int emulateThreaded();
 
 // Printing:
 void printResults();
+void printEmulationStats(double seconds);
 
 
 #endif
\ No newline at end of file
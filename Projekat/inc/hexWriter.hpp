@@ -0,0 +1,23 @@
+#ifndef _hex_writer_h_
+#define _hex_writer_h_
+
+
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include "string.h"
+#include "memoryContent.hpp"
+
+#include <iostream>
+using namespace std;
+
+
+// Writes memory contents as text, 8 bytes per line after their address, '--' for unused bytes in a line:
+//  (formats every byte with fprintf, kept to compare hexWrite with)
+void hexPrint(FILE* outputFile, const vector<MemoryContent>& memoryContents);
+
+// Writes the same text as hexPrint: (formats whole lines from a table of bytes' hex digits, into a large buffer)
+void hexWrite(FILE* outputFile, const vector<MemoryContent>& memoryContents);
+
+
+#endif
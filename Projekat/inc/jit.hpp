@@ -0,0 +1,55 @@
+#ifndef _jit_h_
+#define _jit_h_
+
+#include "emulator.hpp"
+#include <unordered_map>
+#include <vector>
+#include <bitset>
+
+
+// Basic block translator: guest code is compiled block by block into x86-64 code in an executable arena.
+//  A block ends at the first instruction that can change pc (JMP, BEQ, BNE, BGT, CALL, INT, HALT, POP pc, ...),
+//  at the end of a 4KiB page, or after maxBlockInstrs instructions.
+//  Guest registers stay in gpr[]/csr[] and every memory access goes through readWord/writeWord.
+
+const uint jitArenaSize = 16 << 20;
+const uint maxBlockInstrs = 64;
+const uint maxInstrCodeSize = 256;  // Upper bound for the host code of a single guest instruction (including its exits).
+
+// Place in a block's code where it leaves for another block. Starts out returning to emulateJit(), which then patches
+//  the jump to lead straight into the next block (chaining). For exits whose target is only known at runtime,
+//  the target the jump was patched for is remembered in the code as well.
+struct JitExitSlot {
+  unsigned char* jmpRel;  // rel32 of the jump that gets patched.
+  unsigned char* cmpImm;  // imm32 compared with the runtime target (nullptr for exits with a fixed target).
+};
+
+struct JitBlock {
+  uint start, end;        // Guest addresses [start, end) the block was translated from.
+  unsigned char* code;
+};
+
+// Guest words (4B each) of a 4KiB page that some translated block was made from:
+struct JitPage {
+  std::bitset<instrsPerPage> words;
+};
+
+// What a block returns to emulateJit() with: (status 0 - continue at gpr[pc], 1 - HALT)
+struct JitResult {
+  long status;
+  JitExitSlot* slot;  // Exit that should be chained to the block at gpr[pc], or nullptr.
+};
+
+
+// Emulate: (same results as emulate(), but runs translated blocks)
+int emulateJit();
+
+// Called for every guest write, drops translated code if one of its instructions gets overwritten:
+void jitNoteWrite(uint address);
+
+// Throws away all translated blocks:
+void jitFlush();
+void jitFree();
+
+
+#endif
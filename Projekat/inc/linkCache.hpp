@@ -0,0 +1,52 @@
+#ifndef _link_cache_h_
+#define _link_cache_h_
+
+
+#include <vector>
+#include <fstream>
+#include "binaryFile.hpp"
+#include "stringTable.hpp"
+#include "symbolTable.hpp"
+
+#include <iostream>
+using namespace std;
+
+
+// Where one of an input file's sections ended up in the output:
+struct LinkCacheSection {
+  uint name;
+  uint base;
+  uint size;
+};
+
+// What the last link used from an input file:
+struct LinkCacheFile {
+  string fileName;
+  ulong hash;                          // Of the file's content, to tell if it changed.
+  vector<LinkCacheSection> sections;   // Its sections that have content.
+  vector<pair<uint, uint>> globals;    // <symName, value> of the global symbols it defines.
+  vector<pair<uint, uint>> globalSites;  // <address, symName> of relocations that got their value from resSymbolTable.
+};
+
+// State of the last link, kept next to its output for '-incremental': (outputFileName.linkcache)
+//  If only the content of some input files changed, but not their sections' sizes nor which global symbols they define,
+//  the layout stays the same and the old output only needs those files' sections and the relocations of changed symbols.
+class LinkCache {
+public:
+  vector<pair<uint, uint>> placeOptions;  // <sectName, address> sorted by address.
+  ulong outputHash;                       // Of the binary output file, it's patched in place of a full link.
+  vector<LinkCacheFile> files;            // In argv order.
+  SymbolTable resSymbolTable;
+
+  // Binary file support:
+  void bWrite(std::ofstream& file);
+  // Returns -1 (without printing anything) if the file isn't a link cache of the current version:
+  int bRead(std::ifstream& file);
+};
+
+
+// Hash of a file's content: (returns -1 if the file can't be read)
+int hashFile(string path, ulong& hash);
+
+
+#endif
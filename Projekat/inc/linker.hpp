@@ -2,12 +2,25 @@
 #define _linker_h_
 
 
-#include <set>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
+#include <sys/mman.h>  // For writing the binary output file through a mapping.
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <sys/resource.h>  // For the peak memory use in the '-Map' file.
 #include "string.h"
 #include "../inc/symbolTable.hpp"
 #include "../inc/sectionTable.hpp"
 #include "../inc/relocationTables.hpp"
 #include "../inc/memoryContent.hpp"
+#include "../inc/linkCache.hpp"
+#include "../inc/archive.hpp"
+#include "../inc/hexWriter.hpp"
 
 #include <iostream>
 using namespace std;
@@ -16,26 +29,95 @@ using namespace std;
 // Remember inputFileNames, outputFileName, which sections were given the -place option:
 int processCommandLineArguments(int argc, char* argv[]);
 
-// Reads a single assembler's binary output: (curSymbolTable, curSectionTable, curRelocationTable)
-int readAssemblerFile(string fileName);
+// An assembler's binary output given to the linker:
+struct InputFile {
+  string fileName;         // For archive members: archive.a(member.o)
+  string path;             // Of the file in the 'tests' directory. (the archive for archive members)
+  streamoff offset = 0;    // Where the object file starts in it.
+  int status = 0;          // -1 if reading it failed.
+  bool cached = false;     // Unchanged since the last '-incremental' link, so it isn't read again.
+  ulong hash = 0;          // Of the file's content. (for '-incremental')
 
-// Moves bases of all placed sections starting form the given address for the given amount of bytes:
-void moveSectionsAfterAddress(uint address, uint forAmount);
+  vector<string> names;    // The file's string table.
+  vector<uint> fileIds;    // Ids of the file's names in stringTable.
+  streampos tablesStart;   // Where the tables start in the file (after the string table).
 
-// Puts sections from curSectionTable in the correct position among all other sections:
+  SymbolTable symbolTable;
+  SectionTable sectionTable;
+  RelocationTables relocationTables;
+
+  vector<pair<Section*, char*>> outputSections;  // The file's sections and where their content goes in memoryContents.
+  vector<pair<uint, uint>> globalSites;           // <address, symName> of relocations that got their value from resSymbolTable.
+};
+
+// Reads the header and the string table of an assembler's binary output:
+void readAssemblerFileNames(InputFile& file);
+
+// Reads the tables of an assembler's binary output: (names are already interned into file.fileIds)
+void readAssemblerFileTables(InputFile& file);
+
+// Calls work for every input file, on threadCount threads: (returns -1 if it failed for any of them)
+int forEachInputFile(void (*work)(InputFile&), uint first = 0);
+
+// Starts inputFiles over with just the names of the input files:
+void initInputFiles();
+
+// Reads all assembler's binary outputs: (inputFiles from first on, except the cached ones)
+int readAssemblerFiles(uint first = 0);
+
+// Reads the index of every archive given to the linker:
+int readArchives();
+
+// Adds archive members that define extern symbols still undefined to inputFiles, until no more members are needed:
+int extractArchiveMembers();
+
+// Same-named sections from all input files, they are placed next to each other starting from base:
+struct SectionGroup {
+  uint name;
+  vector<Section> sections;  // In the order they were read in.
+  uint size = 0;             // Sum of the sections' content sizes.
+  uint base = 0;
+
+  SectionGroup(uint name) { this->name = name; }
+};
+
+
+// Removes sections that can't be reached through relocations from the entry point: ('--gc-sections' option)
+int collectGarbageSections();
+
+// Collects sections from curSectionTable into groups of same-named sections: (in the order they appear in)
 int placeSection();
 
+// Merges identical pool entries of sections in the same group, where the instructions using them can reach: ('--dedup-pools' option)
+void dedupPools();
+
+// Drops a section's pool entries that are merged with one after it, and moves the rest together:
+//  (keptEntries maps an entry's key to its distance from the group's end, tailSize is the size of the sections after this one)
+void dedupSectionPool(Section& sec, uint tailSize, unordered_map<ulong, uint>& keptEntries);
 
-// Merge contents of successive sections:
+// Gives every section its base: (processedSections will hold all sections sorted by base)
+int layoutSections();
+
+
+// Merge contents of successive sections: (only sizes them in the binary output file, sections' contents are copied in by relocateSections)
 int joinMemoryContents();
 
+// Maps the binary output file into memory: (with fileSize 0, the existing file is mapped as it is)
+int mapOutputFile(ulong fileSize);
+
+// Points memoryContents into the mapped binary output file: (returns -1 if it isn't a linker's output)
+int viewOutputImage();
+
+// Writes the mapped binary output file back and releases it:
+void unmapOutputFile();
+
+// Copies an input file's sections into memoryContents and writes symbol values in their pools:
+void relocateSections(InputFile& file);
+
 
 // Open output file for printing:
 FILE* openOutputFile();
 
-// Writes txt file in the specified format:
-void hexPrint(FILE* outputFile);
-
 // Write txt file:
 int writeTxtFile();
 
@@ -43,4 +125,47 @@ int writeTxtFile();
 int writeBinaryFile();
 
 
+
+/// ---- Link map: ----
+
+// A section of the output, as listed in the '-Map' file:
+struct MapSection {
+  uint base;
+  uint size;
+  uint name;
+  string fileName;  // Of the input file it came from.
+};
+
+// Ends the current phase of the link, its time goes into the '-Map' file:
+void endPhase(const char* name);
+
+// Sections of the output sorted by base: (from the cache after an incremental link, when processedSections aren't all read)
+vector<MapSection> mapSections(bool fromLinkCache);
+
+// Writes where sections and global symbols landed, and how long each phase of the link took: ('-Map' option)
+int writeMapFile(bool fromLinkCache);
+
+
+
+/// ---- Incremental linking: ----
+
+// Name of the cache file written next to the output:
+string linkCacheFileName();
+
+// Reads the previous binary output: (memoryContents)
+int readBinaryFile();
+
+// Where the byte at the given address is in memoryContents: (nullptr if [address, address + size) isn't in any of them)
+char* outputLocation(uint address, uint size);
+
+// Global symbols an input file defines: (with their values after its sections were placed)
+vector<pair<uint, uint>> definedGlobals(InputFile& file);
+
+// Relinks only the input files that changed since the last link with '-incremental':
+//  Returns 0 if the outputs were updated, -1 on a link error, and 1 if a full link is needed.
+int relinkIncrementally();
+
+// Writes the cache for the next '-incremental' link:
+int writeLinkCache();
+
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <fstream>
+#include "binaryFile.hpp"
 
 #include <iostream>
 using namespace std;
@@ -11,24 +12,42 @@ using namespace std;
 
 class MemoryContent {
   uint startAddress;
-  vector<char> content;
+  vector<char> content;   // Bytes, unless they are kept somewhere else. (in the linker's mapped output file)
+  char* data = nullptr;   // Points to content's bytes or to where they are kept.
+  uint size = 0;
 
 public:
   // Constructors:
   MemoryContent() {};
   MemoryContent(uint startAddress, vector<char> content) {
     this->startAddress = startAddress;
-    this->content = content;
+    this->content = std::move(content);
+    this->data = this->content.data();
+    this->size = this->content.size();
   }
+  // Bytes kept somewhere else, that outlive this MemoryContent:
+  MemoryContent(uint startAddress, char* data, uint size) {
+    this->startAddress = startAddress;
+    this->data = data;
+    this->size = size;
+  }
+
+  // Moving keeps data valid, copying wouldn't:
+  MemoryContent(const MemoryContent&) = delete;
+  MemoryContent& operator=(const MemoryContent&) = delete;
+  MemoryContent(MemoryContent&&) = default;
+  MemoryContent& operator=(MemoryContent&&) = default;
 
   // Binary file support:
   void bWrite(ofstream& file);
   void bRead(ifstream& file);
 
   // Getters and Setters:
-  vector<char> getContent() { return content; }   // Currently no need to return by reference.
-  uint getStartAddress() { return startAddress; } // Currently no need to return by reference.
+  const char* getData() const { return data; }
+  char* getData() { return data; }
+  uint getSize() const { return size; }
+  uint getStartAddress() const { return startAddress; }
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,111 @@
+#ifndef _mnemonics_h_
+#define _mnemonics_h_
+
+
+#include <string.h>
+
+
+// Instructions and directives known to the assembler: (every command gets its mnemonic once, when it's parsed)
+enum Mnemonic {
+  MN_UNKNOWN,
+  // Instructions:
+  MN_HALT, MN_INT, MN_IRET, MN_CALL, MN_RET, MN_JMP, MN_BEQ, MN_BNE, MN_BGT, MN_PUSH, MN_POP, MN_XCHG, MN_ADD,
+  MN_SUB, MN_MUL, MN_DIV, MN_NOT, MN_AND, MN_OR, MN_XOR, MN_SHL, MN_SHR, MN_LD, MN_ST, MN_CSRRD, MN_CSRWR,
+  // Directives:
+  DIR_GLOBAL, DIR_EXTERN, DIR_SECTION, DIR_WORD, DIR_SKIP
+};
+
+// A mnemonic and how its machine instructions are encoded:
+struct MnemonicInfo {
+  const char* name;
+  Mnemonic mnemonic;
+  bool isDirective;
+  unsigned char op;       // Opcode.
+  unsigned char mode;     // Mode when the operand is a register or a literal that fits into the displacement.
+  unsigned char memMode;  // Mode when the operand is read from memory. (call, jmp, branches, ld, st)
+};
+
+constexpr MnemonicInfo mnemonicInfos[] = {
+  { "halt",    MN_HALT,     false, 0, 0, 0 },
+  { "int",     MN_INT,      false, 1, 0, 0 },
+  { "iret",    MN_IRET,     false, 9, 6, 3 },   // status <= mem[sp + 4], then pop pc.
+  { "call",    MN_CALL,     false, 2, 0, 1 },
+  { "ret",     MN_RET,      false, 9, 3, 3 },   // pop pc
+  { "jmp",     MN_JMP,      false, 3, 0, 8 },
+  { "beq",     MN_BEQ,      false, 3, 1, 9 },
+  { "bne",     MN_BNE,      false, 3, 2, 10 },
+  { "bgt",     MN_BGT,      false, 3, 3, 11 },
+  { "push",    MN_PUSH,     false, 8, 1, 1 },
+  { "pop",     MN_POP,      false, 9, 3, 3 },
+  { "xchg",    MN_XCHG,     false, 4, 0, 0 },
+  { "add",     MN_ADD,      false, 5, 0, 0 },
+  { "sub",     MN_SUB,      false, 5, 1, 1 },
+  { "mul",     MN_MUL,      false, 5, 2, 2 },
+  { "div",     MN_DIV,      false, 5, 3, 3 },
+  { "not",     MN_NOT,      false, 6, 0, 0 },
+  { "and",     MN_AND,      false, 6, 1, 1 },
+  { "or",      MN_OR,       false, 6, 2, 2 },
+  { "xor",     MN_XOR,      false, 6, 3, 3 },
+  { "shl",     MN_SHL,      false, 7, 0, 0 },
+  { "shr",     MN_SHR,      false, 7, 1, 1 },
+  { "ld",      MN_LD,       false, 9, 1, 2 },
+  { "st",      MN_ST,       false, 8, 0, 2 },
+  { "csrrd",   MN_CSRRD,    false, 9, 0, 0 },
+  { "csrwr",   MN_CSRWR,    false, 9, 4, 4 },
+  { "global",  DIR_GLOBAL,  true,  0, 0, 0 },
+  { "extern",  DIR_EXTERN,  true,  0, 0, 0 },
+  { "section", DIR_SECTION, true,  0, 0, 0 },
+  { "word",    DIR_WORD,    true,  0, 0, 0 },
+  { "skip",    DIR_SKIP,    true,  0, 0, 0 },
+};
+constexpr unsigned mnemonicCount = sizeof(mnemonicInfos) / sizeof(MnemonicInfo);
+
+
+// Perfect hash of the names above: (no two of them land in the same slot, checked at compile time)
+constexpr unsigned mnemonicSlots = 64;
+
+constexpr unsigned mnemonicHash(const char* name, unsigned len) {
+  return ((unsigned char)name[0] * 5 + (unsigned char)name[1] * 38 + (unsigned char)name[len - 1] * 30 + len) & (mnemonicSlots - 1);
+}
+
+constexpr unsigned constStrlen(const char* s) {
+  unsigned len = 0;
+  while (s[len]) len++;
+  return len;
+}
+
+// Slot -> index into mnemonicInfos + 1 (0 for an empty slot):
+struct MnemonicTable {
+  unsigned char slots[mnemonicSlots] = {};
+  bool perfect = true;
+};
+
+constexpr MnemonicTable buildMnemonicTable() {
+  MnemonicTable table;
+  for (unsigned i = 0; i < mnemonicCount; i++) {
+    unsigned slot = mnemonicHash(mnemonicInfos[i].name, constStrlen(mnemonicInfos[i].name));
+    if (table.slots[slot] != 0) table.perfect = false;
+    table.slots[slot] = i + 1;
+  }
+  return table;
+}
+
+constexpr MnemonicTable mnemonicTable = buildMnemonicTable();
+static_assert(mnemonicTable.perfect, "Two mnemonics hash to the same slot, change mnemonicHash.");
+
+
+// Returns the info of an instruction's (or directive's) name, nullptr if there is no such instruction (or directive):
+inline const MnemonicInfo* lookupMnemonic(const char* name, bool isDirective) {
+  unsigned len = strlen(name);
+  if (len < 2) return nullptr;  // Shorter than any of them.
+
+  unsigned slot = mnemonicTable.slots[mnemonicHash(name, len)];
+  if (slot == 0) return nullptr;
+
+  const MnemonicInfo* info = &mnemonicInfos[slot - 1];
+  if (info->isDirective != isDirective || strcmp(info->name, name) != 0) return nullptr;
+  return info;
+}
+
+
+#endif
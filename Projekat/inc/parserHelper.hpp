@@ -2,6 +2,11 @@
 #define _parser_helper_h_
 
 
+#include "mnemonics.hpp"
+#include "arena.hpp"
+#include <vector>
+#include <functional>
+
 /*
   type: 0 - %reg
         1 - [%reg]
@@ -29,24 +34,52 @@ struct command {
   bool isDirective;
   lab* labs;
 	char* name;
+  Mnemonic mnemonic;         // MN_UNKNOWN if name isn't a known instruction (or directive).
+  const MnemonicInfo* info;  // nullptr for MN_UNKNOWN.
 	arg* args;
 	command* next;
 };
 
 
-extern command* commandsHead;
+// Everything one parse works with, so that a process can parse many files: (the lexer gets it as its extra data)
+struct ParserState {
+  command* commandsHead = nullptr;
+  command* commandsCur = nullptr;
+
+  // Args and labels of the command that is being parsed:
+  arg* listOfArgsHead = nullptr;
+  arg* listOfArgsCur = nullptr;
+  lab* listOfLabsHead = nullptr;
+  lab* listOfLabsCur = nullptr;
+
+  int lineNum = 1;
+
+  // Parsed commands, their args and labels all live here: (identifiers have an arena of their own)
+  Arena arena;
+  Arena identifierArena;
+
+  // Interned identifiers, an open addressing hash table: (its size is a power of two, kept at most half full)
+  std::vector<char*> identifiers = std::vector<char*>(1024, nullptr);
+  size_t identifierCount = 0;
 
+  // If set, every parsed command is handed to it instead of being added to the list of commands,
+  //  and its memory is reused for the next one. A command it fails on (returns -1) stops the parser.
+  std::function<int(command*)> commandHandler;
+
+
+  // Returns the arena's copy of an identifier, the same one for every occurrence of it: (so repeated names share storage)
+  char* internIdentifier(const char* text, size_t len);
+
+  arg* createArg(char*, char*, int, int);
+  lab* createLab(char*);
+  // Returns -1 if commandHandler failed on the command:
+  int createCommand(char*, arg*, bool = false, lab* = nullptr);
+};
 
-arg* createArg(char*, char*, int, int);
-command* createCommand(char*, arg*, bool = false, lab* = nullptr);
 
 // For debugging:
 void printArgs(arg*);
 void printCommands(command*);
 
-void freeLabs(const lab*);
-void freeArgs(const arg*);
-void freeCommands(command*);
-
 
 #endif
\ No newline at end of file
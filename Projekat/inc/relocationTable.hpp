@@ -5,27 +5,30 @@
 #include <vector>
 #include <algorithm> // To check if the entry already exists (both the symbol and location must match, checks for matching pair<>)
 #include <fstream>
+#include "binaryFile.hpp"
+#include "stringTable.hpp"
 
 #include <iostream>
 using namespace std;
 
 
 class RelocationTable {
-  vector<pair<string, uint>> entries;  // symbolName, offsetInSectionContentWhereToWriteItsValue
+  vector<pair<uint, uint>> entries;  // symbolName (id in stringTable), offsetInSectionContentWhereToWriteItsValue
 
 public:
   // Checks if the entry already exists (both the symbol and location must match)
-  void addEntry(string symName, uint offsetInSection);
+  void addEntry(uint symName, uint offsetInSection);
 
   // Printing:
-  void printEntries(FILE* outputFile);
+  void printEntries(FILE* outputFile, const StringTable& names = stringTable);
 
   // Binary file support:
   void bWrite(std::ofstream& file);
-  void bRead(std::ifstream& file);
+  void bRead(std::ifstream& file, const vector<uint>& fileIds);
 
   // Getters and Setters:
-  vector<pair<string, uint>> getEntries() { return entries; }
+  const vector<pair<uint, uint>>& getEntries() const { return entries; }
+  void setEntries(vector<pair<uint, uint>> entries) { this->entries = std::move(entries); }
 };
 
 
@@ -11,27 +11,27 @@ using namespace std;
 
 
 class RelocationTables {
-  unordered_map<string, RelocationTable> relocationTables;  // sectionName -> Secition's relocation table. 
-  vector<string> sectionOrder; // For iterating through relocationTables in the chronological order of sections.
+  unordered_map<uint, RelocationTable> relocationTables;  // sectionName (id in stringTable) -> Secition's relocation table. 
+  vector<uint> sectionOrder; // For iterating through relocationTables in the chronological order of sections.
 
 public:
   
   // Will create a new map key if it doesn't find an existing one.        
-  void addOrUpdateTable(string sectName, RelocationTable& relTable);
+  void addOrUpdateTable(uint sectName, RelocationTable relTable);
 
   // Printing:
-  void printRelocationTables(FILE* outputFile);
+  void printRelocationTables(FILE* outputFile, const StringTable& names = stringTable);
 
   // Binary file support:
   void bWrite(std::ofstream& file);
-  void bRead(std::ifstream& file);
+  void bRead(std::ifstream& file, const vector<uint>& fileIds);
 
 
   /// ---- For Linker: ----
 
   // Get a section's RelocationTable
-  RelocationTable getRelTable(string sectName);
-  vector<string> getSectionOrder() { return sectionOrder; }
+  const RelocationTable& getRelTable(uint sectName) const;
+  const vector<uint>& getSectionOrder() const { return sectionOrder; }
 };
 
 
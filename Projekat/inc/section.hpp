@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <vector>
 #include <fstream>
+#include "binaryFile.hpp"
+#include "stringTable.hpp"
 #include <sstream>
 #include <iomanip>
 #include "relocationTable.hpp"
@@ -15,18 +17,22 @@ using namespace std;
 
 
 class Section {
-  std::string name;
-  uint base;
+  uint name;                   // Id of the section's name in stringTable.
+  uint base = 0;
   std::vector<char> content;   // Bytes representing machineInstruction and pool afterwards.
   uint length;                 // Length of machineInstructions content (for total length of content use content.size()). 
 
   std::unordered_map<int, uint> poolEntriesLit;         // literalTabel: value -> location
-  std::unordered_map<std::string, uint> poolEntriesSym; // literalTabel: symbol -> location
+  std::unordered_map<uint, uint> poolEntriesSym;        // literalTabel: symbol (id in stringTable) -> location
 
   // Needed to assign location values in literals table chronologically:
   uint orderId = 0;
   vector<pair<uint,int>> orderOfLits;    // <orderId,litValue> 
-  vector<pair<uint,string>> orderOfSyms;  // <orderId,symName>
+  vector<pair<uint,uint>> orderOfSyms;    // <orderId,symName>
+
+  vector<uint> poolRefs;  // Locations of machine instructions that address the pool (pc relative), so the linker can move pool entries.
+
+  void growContent(uint size);
 
   int asmFileId;  // When linker has to deal with multiple section's with the same name from different asm files this will be used
                   //  to get the one we need. Linker will initialize this value as it reads an asm file.
@@ -34,7 +40,7 @@ class Section {
 public:
   // Constructors:
   Section() {}
-  Section(std::string name) { this->name = name; }
+  Section(uint name) { this->name = name; }
 
 
   // Operator overload:
@@ -43,10 +49,13 @@ public:
 
   // Only adds a lit/sym to literalTable if it's not already there.
   void addPoolEntry(int value);
-  void addPoolEntry(std::string symbol);
+  void addPoolEntrySym(uint symbol);
 
   uint getPoolEntryLocation(int key);
-  uint getPoolEntryLocation(string key);
+  uint getPoolEntrySymLocation(uint key);
+
+  // Remember a machine instruction that addresses the pool:
+  void addPoolRef(uint position) { poolRefs.push_back(position); }
   
 
   // Fill literalTables with values (locations of lits/syms) after first cycle (that's when the lenght of machine code is known)
@@ -56,38 +65,42 @@ public:
 
   // Add int to the section's content: (position is given in bytes)
   void addContent(uint position, int item);
-  void addContentInstruction(uint position, string machineInstr);
+  void addContentInstruction(uint position, uint machineInstr);
+
+  // Overwrite the 12 bit displacement of an already written machineInstr:
+  void setInstructionDisp(uint position, uint disp);
 
 
   // Printing:
   void printPoolEntries();
   void printContent(FILE* outputFile);
-  void printSection(FILE* outputFile);
+  void printSection(FILE* outputFile, const StringTable& names = stringTable);
 
 
   // Binary file support:
   void bWrite(std::ofstream& file);
-  void bRead(std::ifstream& file);
+  void bRead(std::ifstream& file, const vector<uint>& fileIds);
 
 
   // Getters and Setters:
-  std::string getName() const { return this->name; }
-  void setName(std::string name) { this->name = name; }
+  uint getName() const { return this->name; }
+  void setName(uint name) { this->name = name; }
 
   uint getBase() const { return this->base; }
   void setBase(uint base) { this->base = base; }
 
-  std::vector<char> getContent() const { return this->content; }
-  void setContent(std::vector<char> content) { this->content = content; }
+  const std::vector<char>& getContent() const { return this->content; }
+  void setContent(std::vector<char> content) { this->content = std::move(content); }
 
   uint getLength() const { return this->length; }
   void setLength(uint length) { this->length = length; }
 
-  std::unordered_map<int,uint> getPoolEntriesLit() const { return this->poolEntriesLit; }
-  void setPoolEntriesLit(std::unordered_map<int,uint> poolEntriesLit) { this->poolEntriesLit = poolEntriesLit; }
+  const std::unordered_map<int,uint>& getPoolEntriesLit() const { return this->poolEntriesLit; }
+  void setPoolEntriesLit(std::unordered_map<int,uint> poolEntriesLit) { this->poolEntriesLit = std::move(poolEntriesLit); }
 
-  std::unordered_map<std::string,uint> getPoolEntriesSym() const { return this->poolEntriesSym; }
-  void setPoolEntriesSym(std::unordered_map<std::string,uint> poolEntriesSym) { this->poolEntriesSym = poolEntriesSym; }
+  const std::unordered_map<uint,uint>& getPoolEntriesSym() const { return this->poolEntriesSym; }
+  void setPoolEntriesSym(std::unordered_map<uint,uint> poolEntriesSym) { this->poolEntriesSym = std::move(poolEntriesSym); }
+  const vector<uint>& getPoolRefs() const { return this->poolRefs; }
 
 
   /// ---- For Linker: ----
@@ -96,27 +109,6 @@ public:
   //  Linker will initialize this values as it is processing the asm files.
   int getAsmFileId() const { return asmFileId; }
   void setAsmFileId(int id) { asmFileId = id; }
-
-  // When linker makes an executable file, it will write final symbols' values into the section's pool:
-  void writeRelocations(RelocationTable relTable, SymbolTable* sectionSymbolTable, SymbolTable linkerSymbolTable) {
-    vector<pair<string, uint>> relEntries = relTable.getEntries();
-
-    for (uint i = 0; i < relEntries.size(); i++) { 
-      string symName = relEntries[i].first;
-      int position = relEntries[i].second;
-
-      SymbolTableEntry* localSymbol = sectionSymbolTable->lookFor(symName);
-
-      // For local symbol, get its value from section's SymbolTable: 
-      if (localSymbol && localSymbol->getType() != 'e') {
-        addContent(position, localSymbol->getValue());
-      } 
-      // For extern symbol, get its value from linker's resulting SymbolTables:
-      else {
-        addContent(position, linkerSymbolTable.lookFor(symName)->getValue());
-      }
-    }
-  }
 };
 
 #endif
\ No newline at end of file
@@ -11,19 +11,22 @@ using namespace std;
 
 
 class SectionTable {
-  unordered_map<string, Section> sectionTable;
-  vector<string> sectionOrder;  // For iterating through sectionTable in the chronological order of sections.
+  unordered_map<uint, Section> sectionTable;  // sectName (id in stringTable) -> section
+  vector<uint> sectionOrder;  // For iterating through sectionTable in the chronological order of sections.
 
 public:
 
   // Fetches a section from the section table:
-  Section* lookFor(string sectName);
+  Section* lookFor(uint sectName);
 
   // Adds a section to the section table:
-  void addSection(string sectName, Section section);
+  void addSection(uint sectName, Section section);
 
   // Updates a section in the map by swapping it with the given updated object:
   void updateSection(Section section);
+
+  // Removes a section from the section table:
+  void removeSection(uint sectName);
   
 
   // Fill each literalTables with values (locations of lits/syms) after first cycle (that's when the lenght of machine code is known)
@@ -32,22 +35,22 @@ public:
 
 
   // Printing:
-  void printSectionTables(FILE* outputFile);
+  void printSectionTables(FILE* outputFile, const StringTable& names = stringTable);
 
 
   // Binary file support:
   void bWrite(std::ofstream& file);
-  void bRead(std::ifstream& file);
+  void bRead(std::ifstream& file, const vector<uint>& fileIds);
 
 
   // Getters and Setters:
-  unordered_map<string, Section>& getSections() { return sectionTable; }
-  vector<string> getSectionOrder() { return sectionOrder; }
+  unordered_map<uint, Section>& getSections() { return sectionTable; }
+  const vector<uint>& getSectionOrder() const { return sectionOrder; }
 
 
   // ---- For Linker: ----
   void setSectionsAsmFileId(int id) { 
-    for (unordered_map<string, Section>::iterator i = sectionTable.begin(); i != sectionTable.end(); i++) {
+    for (unordered_map<uint, Section>::iterator i = sectionTable.begin(); i != sectionTable.end(); i++) {
       i->second.setAsmFileId(id);
     } 
   }
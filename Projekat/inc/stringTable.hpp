@@ -0,0 +1,52 @@
+#ifndef _string_table_h_
+#define _string_table_h_
+
+
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <fstream>
+#include "binaryFile.hpp"
+
+#include <iostream>
+using namespace std;
+
+
+// Ids of names that every StringTable starts with:
+const uint undId = 0;  // "UND" - section that the code before the first .section directive belongs to.
+const uint tbdId = 1;  // "TBD" - section of a symbol that was used but not yet defined.
+const uint extId = 2;  // "EXT" - section of a symbol declared extern.
+
+
+// Interns symbol and section names, so that the tables can refer to them by dense uint ids:
+class StringTable {
+  deque<string> names;              // id -> name (deque keeps references to names valid as it grows)
+  unordered_map<string, uint> ids;  // name -> id
+
+public:
+  // Constructors:
+  StringTable();
+
+  // Returns the id of the given name, adding it if it's seen for the first time:
+  uint intern(const string& name);
+  uint intern(const char* name) { return intern(string(name)); }
+
+  const string& name(uint id) const { return names[id]; }
+  uint size() const { return names.size(); }
+
+  // Interns names read from a file, fileIds gets the id in this table of every one of them:
+  void intern(const vector<string>& fileNames, vector<uint>& fileIds);
+
+  // Binary file support: (an object file carries the names its tables refer to)
+  void bWrite(std::ofstream& file);
+  static void bReadNames(std::ifstream& file, vector<string>& fileNames);
+};
+
+// Reads a name id written to a file and returns its id in stringTable: (fails the stream for ids the file doesn't have)
+uint bReadId(std::ifstream& file, const vector<uint>& fileIds);
+
+// Names used by the tables of the assembler/linker:
+extern StringTable stringTable;
+
+
+#endif
@@ -3,49 +3,61 @@
 
 
 #include <unordered_map>
+#include <unordered_set>
 #include "string.h"
 #include "symbolTableEntry.hpp"
+#include "stringTable.hpp"
 
 #include <iostream>
 using namespace std;
 
 
 class SymbolTable {
-  unordered_map<string, SymbolTableEntry> symbolTable;  // symName -> entry
+  unordered_map<uint, SymbolTableEntry> symbolTable;  // symName (id in stringTable) -> entry
 
 public:
   // Constructors:
   SymbolTable() {}
-  SymbolTable(unordered_map<string, SymbolTableEntry> symbolTable) { this->symbolTable = symbolTable; }
+  SymbolTable(unordered_map<uint, SymbolTableEntry> symbolTable) { this->symbolTable = symbolTable; }
 
 
   // Creates a new SymbolEntry in the SymbolTable:
-  void createSymbolEntry(string name, string section, uint value, char type);
+  void createSymbolEntry(uint name, uint section, uint value, char type);
 
   // Fetches a SymbolTableEntry:
-  SymbolTableEntry* lookFor(string symName);
+  SymbolTableEntry* lookFor(uint symName);
 
   // Checks if there are undefined non-extern symbol after the first assembler cycle:
-  int validateSymbolTable();
+  int validateSymbolTable(const StringTable& names = stringTable);
 
   // Funs for printing:
-  void printSymbolTable(FILE* outputFile);
+  void printSymbolTable(FILE* outputFile, const StringTable& names = stringTable);
+
+  // Getters:
+  const unordered_map<uint, SymbolTableEntry>& getSymbols() const { return symbolTable; }
 
   // Binary file support:
   void bWrite(std::ofstream& file);
-  void bRead(std::ifstream& file);
+  void bRead(std::ifstream& file, const vector<uint>& fileIds);
 
 
   /// ---- Funs needed for linker: ----
 
   // Increases values of SymbolTableEntries that belong to the given section by section's base address:
-  void updateLocalSymbolsValuesForSection(string sectName, uint sectBase);
+  void updateLocalSymbolsValuesForSection(uint sectName, uint sectBase);
+
+  // Removes SymbolTableEntries that belong to the given section: (for sections '--gc-sections' drops)
+  void removeSymbolsOfSection(uint sectName);
+
+  // Removes extern symbols that aren't among the used ones: (after '--gc-sections' drops the sections that used them)
+  void removeUnusedExterns(const unordered_set<uint>& used);
 
   // Move global symbols from this SymbolTable to linker's resulting SymbolTable:
   int exportGlobalSymbols(SymbolTable& resSymbolTable);
 
   // Checks if every extern symbol in this SymbolTable is defined in the linker's resulting SymbolTable:
-  int checkForUndefinedExtern(SymbolTable& resSymbolTable);
+  //  (if undefined is given, undefined extern symbols are added to it instead of being an error)
+  int checkForUndefinedExtern(SymbolTable& resSymbolTable, vector<uint>* undefined = nullptr);
 };
 
 
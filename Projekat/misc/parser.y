@@ -1,20 +1,25 @@
+%code requires {
+  // The lexer's handle: (same typedef as in the generated lexer.h)
+  #ifndef YY_TYPEDEF_YY_SCANNER_T
+  #define YY_TYPEDEF_YY_SCANNER_T
+  typedef void* yyscan_t;
+  #endif
+
+  struct ParserState;
+}
+
 %{
   #include "../inc/parserHelper.hpp"
   #include <iostream>
   #include <cstring>
   using namespace std;
-
-  extern "C" int yylex();
-  extern int yyparse();
-  extern FILE *yyin;
-  extern int line_num;
-
-  arg* listOfArgsHead = NULL, *listOfArgsCur = listOfArgsHead;
-  lab* listOfLabsHead = NULL, *listOfLabsCur = listOfLabsHead;
- 
-  void yyerror(const char* s);
 %}
 
+// Reentrant: the parser and the lexer keep no global state, all of it is in ParserState.
+%define api.pure full
+%parse-param {yyscan_t scanner} {ParserState* state}
+%lex-param {yyscan_t scanner}
+
 %union {
   int number;
   char* identifier;
@@ -33,6 +38,11 @@
 %type <number> literal;
 %type <identifier> symbol;
 
+%code {
+  int yylex(YYSTYPE* lvalp, yyscan_t scanner);
+  void yyerror(yyscan_t scanner, ParserState* state, const char* s);
+}
+
 
 %%
 
@@ -58,17 +68,15 @@ label:
   IDENTIFIER COLON {
     //cout << "Parser found label: " << $1 << endl;
 
-    lab* l = (lab*)malloc(sizeof(lab));
-    l->name = $1;
-    l->next = NULL;
+    lab* l = state->createLab($1);
 
-    if (!listOfLabsHead) {
-      listOfLabsHead = l;
-      listOfLabsCur = listOfLabsHead;
+    if (!state->listOfLabsHead) {
+      state->listOfLabsHead = l;
+      state->listOfLabsCur = state->listOfLabsHead;
     }
     else {
-      listOfLabsCur->next = l;
-      listOfLabsCur = listOfLabsCur->next;
+      state->listOfLabsCur->next = l;
+      state->listOfLabsCur = state->listOfLabsCur->next;
     }
   };
 
@@ -80,58 +88,58 @@ directive:
   DOT IDENTIFIER listOfIdentifiers {
     //cout << "Parser found directive: " << $2 << endl;
     
-    if (listOfLabsHead) {
-      createCommand($2, listOfArgsHead, true, listOfLabsHead);
-      listOfLabsHead = NULL;
-      listOfLabsCur = listOfLabsHead;
+    if (state->listOfLabsHead) {
+      if (state->createCommand($2, state->listOfArgsHead, true, state->listOfLabsHead) == -1) YYABORT;
+      state->listOfLabsHead = NULL;
+      state->listOfLabsCur = state->listOfLabsHead;
     }
     else {
-      createCommand($2, listOfArgsHead, true);
+      if (state->createCommand($2, state->listOfArgsHead, true) == -1) YYABORT;
     }
 
-    listOfArgsHead = NULL;
-    listOfArgsCur = listOfArgsHead;
+    state->listOfArgsHead = NULL;
+    state->listOfArgsCur = state->listOfArgsHead;
   };
 
 listOfIdentifiers:
   listOfIdentifiers COMMA IDENTIFIER {
-    if (!listOfArgsHead) {
-        listOfArgsHead = createArg(NULL, $3, 0, 5);
-        listOfArgsCur = listOfArgsHead;
+    if (!state->listOfArgsHead) {
+        state->listOfArgsHead = state->createArg(NULL, $3, 0, 5);
+        state->listOfArgsCur = state->listOfArgsHead;
       }
       else {
-        listOfArgsCur->next = createArg(NULL, $3, 0, 5);
-        listOfArgsCur = listOfArgsCur->next;
+        state->listOfArgsCur->next = state->createArg(NULL, $3, 0, 5);
+        state->listOfArgsCur = state->listOfArgsCur->next;
       }
   }
   | listOfIdentifiers COMMA NUMBER { 
-      if (!listOfArgsHead) {
-        listOfArgsHead = createArg(NULL, NULL, $3, 4);
-        listOfArgsCur = listOfArgsHead;
+      if (!state->listOfArgsHead) {
+        state->listOfArgsHead = state->createArg(NULL, NULL, $3, 4);
+        state->listOfArgsCur = state->listOfArgsHead;
       }
       else {
-        listOfArgsCur->next = createArg(NULL, NULL, $3, 4);
-        listOfArgsCur = listOfArgsCur->next;
+        state->listOfArgsCur->next = state->createArg(NULL, NULL, $3, 4);
+        state->listOfArgsCur = state->listOfArgsCur->next;
       }
     }
   | IDENTIFIER { 
-      if (!listOfArgsHead) {
-        listOfArgsHead = createArg(NULL, $1, 0, 5);
-        listOfArgsCur = listOfArgsHead;
+      if (!state->listOfArgsHead) {
+        state->listOfArgsHead = state->createArg(NULL, $1, 0, 5);
+        state->listOfArgsCur = state->listOfArgsHead;
       }
       else {
-        listOfArgsCur->next = createArg(NULL, $1, 0, 5);
-        listOfArgsCur = listOfArgsCur->next;
+        state->listOfArgsCur->next = state->createArg(NULL, $1, 0, 5);
+        state->listOfArgsCur = state->listOfArgsCur->next;
       }
     }
   | NUMBER { 
-      if (!listOfArgsHead) {
-        listOfArgsHead = createArg(NULL, NULL, $1, 4);
-        listOfArgsCur = listOfArgsHead;
+      if (!state->listOfArgsHead) {
+        state->listOfArgsHead = state->createArg(NULL, NULL, $1, 4);
+        state->listOfArgsCur = state->listOfArgsHead;
       }
       else {
-        listOfArgsCur->next = createArg(NULL, NULL, $1, 4);
-        listOfArgsCur = listOfArgsCur->next;
+        state->listOfArgsCur->next = state->createArg(NULL, NULL, $1, 4);
+        state->listOfArgsCur = state->listOfArgsCur->next;
       }
     }
   | ;
@@ -139,47 +147,47 @@ listOfIdentifiers:
 instruction:
   IDENTIFIER {
     //cout << "Parser found instruction: " << $1 << endl;
-    createCommand($1, NULL, false, listOfLabsHead);
-    listOfLabsHead = NULL; listOfLabsCur = listOfLabsHead;
+    if (state->createCommand($1, NULL, false, state->listOfLabsHead) == -1) YYABORT;
+    state->listOfLabsHead = NULL; state->listOfLabsCur = state->listOfLabsHead;
   }
   | IDENTIFIER arg {
     //cout << "Parser found instruction with one arg: " << $1 << endl;
-    createCommand($1, $2, false, listOfLabsHead);
-    listOfLabsHead = NULL; listOfLabsCur = listOfLabsHead;
+    if (state->createCommand($1, $2, false, state->listOfLabsHead) == -1) YYABORT;
+    state->listOfLabsHead = NULL; state->listOfLabsCur = state->listOfLabsHead;
   }
   | IDENTIFIER arg COMMA arg {
     //cout << "Parser found instruction with two args: " << $1 << endl;
     struct arg *first_arg = $2;
 	  first_arg->next = $4;
-	  createCommand($1, $2, false, listOfLabsHead);
-    listOfLabsHead = NULL; listOfLabsCur = listOfLabsHead;
+	  if (state->createCommand($1, $2, false, state->listOfLabsHead) == -1) YYABORT;
+    state->listOfLabsHead = NULL; state->listOfLabsCur = state->listOfLabsHead;
   }
   | IDENTIFIER arg COMMA arg COMMA arg {
     //cout << "Parser found instruction with three args: " << $1 << endl;
     struct arg *first_arg = $2;
 	  first_arg->next = $4;
     first_arg->next->next = $6;
-	  createCommand($1, $2, false, listOfLabsHead);
-    listOfLabsHead = NULL; listOfLabsCur = listOfLabsHead;
+	  if (state->createCommand($1, $2, false, state->listOfLabsHead) == -1) YYABORT;
+    state->listOfLabsHead = NULL; state->listOfLabsCur = state->listOfLabsHead;
   };
 
 arg:
   PERCENT reg 
-  { $$ = createArg($2, NULL, 0, 0); }
+  { $$ = state->createArg($2, NULL, 0, 0); }
   | OPEN PERCENT reg CLOSE
-  { $$ = createArg($3, NULL, 0, 1); }
+  { $$ = state->createArg($3, NULL, 0, 1); }
   | OPEN PERCENT reg PLUS literal CLOSE
-  { $$ = createArg($3, NULL, $5, 2); }
+  { $$ = state->createArg($3, NULL, $5, 2); }
   | OPEN PERCENT reg PLUS symbol CLOSE
-  { $$ = createArg($3, $5, 0, 3); }
+  { $$ = state->createArg($3, $5, 0, 3); }
   | DOLLAR literal
-  { $$ = createArg(NULL, NULL, $2, 4); }
+  { $$ = state->createArg(NULL, NULL, $2, 4); }
   | DOLLAR symbol
-  { $$ = createArg(NULL, $2, 0, 5); }
+  { $$ = state->createArg(NULL, $2, 0, 5); }
   | literal
-  { $$ = createArg(NULL, NULL, $1, 6); }
+  { $$ = state->createArg(NULL, NULL, $1, 6); }
   | symbol
-  { $$ = createArg(NULL, $1, 0, 7); }
+  { $$ = state->createArg(NULL, $1, 0, 7); }
 
 reg:
   IDENTIFIER;
@@ -198,7 +206,6 @@ ENDLS:
 %%
 
 
-void yyerror(const char *s) {
-  cout << "Parser ERROR on line " << line_num << "!  Message: " << s << endl;
-  exit(-1);
+void yyerror(yyscan_t scanner, ParserState* state, const char *s) {
+  cout << "Parser ERROR on line " << state->lineNum << "!  Message: " << s << endl;
 }
\ No newline at end of file
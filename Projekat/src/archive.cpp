@@ -0,0 +1,63 @@
+#include "../inc/archive.hpp"
+
+
+// Size in bytes of the index, so the members' offsets are known before it's written:
+uint Archive::indexSize() {
+  uint size = binaryFileHeaderSize + sizeof(uint);
+  for (ArchiveMember& m : members) {
+    size += sizeof(uint) + m.name.length() + 3 * sizeof(uint);
+    for (string& g : m.globals) size += sizeof(uint) + g.length();
+  }
+  return size;
+}
+
+
+// Binary file support: (of the index)
+void Archive::bWriteIndex(std::ofstream& file) {
+  bWriteHeader(file, archiveMagic);
+
+  bWriteUint(file, members.size());
+  for (ArchiveMember& m : members) {
+    bWriteString(file, m.name);
+    bWriteUint(file, m.offset);
+    bWriteUint(file, m.size);
+
+    bWriteUint(file, m.globals.size());
+    for (string& g : m.globals) bWriteString(file, g);
+  }
+}
+
+int Archive::bReadIndex(std::ifstream& file) {
+  if (bCheckHeader(file, archiveMagic, fileName) == -1) return -1;
+
+  uint len = bReadUint(file);
+  for (uint i = 0; i < len && !file.fail(); i++) {
+    members.push_back(ArchiveMember());
+    ArchiveMember& m = members.back();
+    bReadString(file, m.name);
+    m.offset = bReadUint(file);
+    m.size = bReadUint(file);
+
+    uint count = bReadUint(file);
+    for (uint j = 0; j < count && !file.fail(); j++) {
+      m.globals.push_back("");
+      bReadString(file, m.globals.back());
+    }
+  }
+
+  if (file.fail()) {
+    fprintf(stderr, "Error: %s is truncated.\n", fileName.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+
+// Fills symbolIndex from members' globals:
+void Archive::buildSymbolIndex() {
+  for (uint i = 0; i < members.size(); i++) {
+    for (string& g : members[i].globals) {
+      symbolIndex.insert(make_pair(stringTable.intern(g), i));  // Will not overwrite an earlier member's definition.
+    }
+  }
+}
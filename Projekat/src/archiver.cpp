@@ -0,0 +1,118 @@
+#include "../inc/archiver.hpp"
+
+
+vector<string> inputFileNames;
+string outputFileName = "";
+
+Archive archive;
+vector<vector<char>> memberContents;  // Members' object files, in the order of archive.members.
+
+
+// Remember the archive's name and the object files that go into it:
+int processCommandLineArguments(int argc, char* argv[]) {
+  bool inputErr = false;
+
+  for (int i = 1; i < argc; i++) {
+    // Input file:
+    if (argv[i][0] != '-' && string(argv[i]).length() > 2 
+    && strcmp(string(argv[i]).substr(string(argv[i]).length() - 2).c_str(), ".o") == 0) {
+      inputFileNames.push_back(argv[i]);
+    }
+    // Option '-o':
+    else if (strcmp(argv[i], "-o") == 0) {
+      if (i == argc - 1 || argv[i+1][0] == '-' || strcmp(outputFileName.c_str(), "") != 0) {
+        inputErr = true;
+        break;
+      }
+      outputFileName = argv[++i];
+    }
+    else inputErr = true;
+  }
+
+  if (inputErr || inputFileNames.size() == 0 || outputFileName == "") {
+    fprintf(stderr, "Error: Invalid command arguments given to archiver. (archiver -o lib.a file.o ...)\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+// Reads an object file and the names of the global symbols it defines:
+int readMember(string fileName, vector<char>& content, vector<string>& globals) {
+  string prefix = "../tests/";
+  ifstream in(prefix + fileName, ios::binary);
+  if (in.fail()) {
+    fprintf(stderr, "Archiver Error: couldn't find %s in the 'tests' directory.\n", fileName.c_str());
+    return -1;
+  }
+  if (bCheckHeader(in, objectFileMagic, fileName) == -1) return -1;
+
+  vector<string> names;
+  vector<uint> fileIds;
+  SymbolTable symbolTable;
+  StringTable::bReadNames(in, names);
+  stringTable.intern(names, fileIds);
+  symbolTable.bRead(in, fileIds);
+  if (in.fail()) {
+    fprintf(stderr, "Archiver Error: %s is truncated.\n", fileName.c_str());
+    return -1;
+  }
+
+  for (const pair<const uint, SymbolTableEntry>& sym : symbolTable.getSymbols()) {
+    if (sym.second.type == 'g') globals.push_back(stringTable.name(sym.first));
+  }
+  sort(globals.begin(), globals.end());
+
+  // The whole object file is stored in the archive:
+  in.seekg(0, ios::end);
+  content.resize(in.tellg());
+  in.seekg(0);
+  in.read(content.data(), content.size());
+
+  return 0;
+}
+
+// Writes the index followed by the members' object files:
+int writeArchive() {
+  // Members' offsets depend on the index size:
+  uint offset = archive.indexSize();
+  for (uint i = 0; i < archive.members.size(); i++) {
+    archive.members[i].offset = offset;
+    archive.members[i].size = memberContents[i].size();
+    offset += memberContents[i].size();
+  }
+
+  string prefix = "../tests/";
+  ofstream out(prefix + outputFileName, ios::binary);
+  if (out.fail()) {
+    fprintf(stderr, "Archiver Error: couldn't create %s in the 'tests' directory.\n", outputFileName.c_str());
+    return -1;
+  }
+
+  archive.bWriteIndex(out);
+  for (vector<char>& content : memberContents) {
+    out.write(content.data(), content.size());
+  }
+  out.close();
+
+  return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+  /// Process command line arguments:
+  if (processCommandLineArguments(argc, argv) == -1) return -1;
+
+  /// Read the object files:
+  memberContents.resize(inputFileNames.size());
+  for (uint i = 0; i < inputFileNames.size(); i++) {
+    archive.members.push_back(ArchiveMember());
+    archive.members.back().name = inputFileNames[i];
+    if (readMember(inputFileNames[i], memberContents[i], archive.members.back().globals) == -1) return -1;
+  }
+
+  /// Write the archive:
+  if (writeArchive() == -1) return -1;
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "../inc/arena.hpp"
+
+
+void* Arena::allocate(size_t size) {
+  size = (size + alignment - 1) & ~(alignment - 1);
+
+  if (size > left) {
+    // Requests bigger than a block get a block of their own, the current block keeps its free space:
+    if (size > blockSize / 4) {
+      char* block = (char*)malloc(size);
+      bigBlocks.push_back(block);
+      return block;
+    }
+
+    cur = (char*)malloc(blockSize);
+    left = blockSize;
+    blocks.push_back(cur);
+  }
+
+  void* p = cur;
+  cur += size;
+  left -= size;
+  return p;
+}
+
+char* Arena::copyString(const char* text, size_t len) {
+  char* s = (char*)allocate(len + 1);
+  memcpy(s, text, len);
+  s[len] = '\0';
+  return s;
+}
+
+void Arena::release() {
+  for (char* block : blocks) free(block);
+  for (char* block : bigBlocks) free(block);
+  blocks.clear();
+  bigBlocks.clear();
+  cur = nullptr;
+  left = 0;
+}
+
+void Arena::reset() {
+  for (char* block : bigBlocks) free(block);
+  bigBlocks.clear();
+  if (blocks.empty()) return;
+
+  for (size_t i = 1; i < blocks.size(); i++) free(blocks[i]);
+  blocks.resize(1);
+  cur = blocks[0];
+  left = blockSize;
+}
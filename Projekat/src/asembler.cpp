@@ -4,26 +4,19 @@
 
 
 const uint maxLit = 1 << 12; 
-string outputFileName;
-
-SymbolTable symbolTable = SymbolTable();
-SectionTable sectionTable = SectionTable();
-RelocationTables relocationTables = RelocationTables();
-
-uint locCounter = 0;
-Section curSection("UND");
-RelocationTable curRelTable;
+const uint poolIndexTag = 1u << 31;    // '--single-pass': marks relocation offsets that are still indexes of pool entries.
 
 
 // Add labels to the SymbolTable: (or update value of symbol used before def, or throw multiple definition exception)
-int processCommandLabels(lab* labels) {
+int Assembler::processCommandLabels(lab* labels) {
   lab* labs = labels;
 
   while (labs) {
-    SymbolTableEntry* ste = symbolTable.lookFor(labs->name);
+    uint name = stringTable.intern(labs->name);
+    SymbolTableEntry* ste = symbolTable.lookFor(name);
 
     if (ste == nullptr) {
-      symbolTable.createSymbolEntry(labs->name, curSection.getName(), locCounter, 'l');
+      symbolTable.createSymbolEntry(name, curSection.getName(), locCounter, 'l');
     }
     else if (ste->getValue() != -1) {
       fprintf(stderr, "Multiple definitions of label: %s\n", labs->name);
@@ -43,53 +36,58 @@ int processCommandLabels(lab* labels) {
 // Add used symbol to the SymbolTable (or do the necessary update to its SymbolTable entry).
 //  If symbol is a section, it will be added to sectionTable as well. 
 //  If this is the first use of this symbol in THIS section, it will be added to the section's pool as well.
-int processCommandSymbol(arg* a, command* cmnd) {
+int Assembler::processCommandSymbol(arg* a, command* cmnd) {
   if (a->type == 3) {
     fprintf(stderr, "ERROR: Can't use syntax [reg + symbol] unless the symbol is defined using '.equ' and shorter than 12b.");
     return -1;
   }
 
-  char* sym = a->sym;
+  uint sym = stringTable.intern(a->sym);
   SymbolTableEntry* ste = symbolTable.lookFor(sym);
 
   // Special directives:
-  if (cmnd->isDirective && strcmp(cmnd->name, "section") == 0) {
+  if (cmnd->mnemonic == DIR_SECTION) {
+    // A section can't be continued once another one has started: (its code would start over at 0)
+    if (sym == curSection.getName() || sectionTable.lookFor(sym)) {
+      fprintf(stderr, "ERROR: Section %s is already started, a section can't be opened more than once.\n", a->sym);
+      return -1;
+    }
+
     // Add the old section to Section Table:
-    curSection.setLength(locCounter);
-    sectionTable.addSection(curSection.getName(), curSection);
+    endSection();
 
     // Start a new section:
     locCounter = 0;
     curSection = Section(sym);
     symbolTable.createSymbolEntry(sym, curSection.getName(), 0, 'l');
   }
-  if (cmnd->isDirective && strcmp(cmnd->name, "global") == 0) {
+  if (cmnd->mnemonic == DIR_GLOBAL) {
     if (ste != nullptr) {
       ste->setType('g');
     }
     else {
-      symbolTable.createSymbolEntry(sym, "TBD", -1, 'g');
+      symbolTable.createSymbolEntry(sym, tbdId, -1, 'g');
     }
   }
-  else if (cmnd->isDirective && strcmp(cmnd->name, "extern") == 0) {
+  else if (cmnd->mnemonic == DIR_EXTERN) {
     if (ste != nullptr) {
       ste->setType('e');
     }
     else {
-      symbolTable.createSymbolEntry(sym, "EXT", -1, 'e');
+      symbolTable.createSymbolEntry(sym, extId, -1, 'e');
     }
   }
   else {
     // If this is the first occurance of the symbol, add it to the symbol table.
     if (ste == nullptr) {
-      symbolTable.createSymbolEntry(sym, "TBD", -1, 'l');
+      symbolTable.createSymbolEntry(sym, tbdId, -1, 'l');
     }
 
     // If this is the first occurence of the symbol in THIS section, add it to the section's pool.
     if (!cmnd->isDirective 
     && curSection.getPoolEntriesSym().find(sym) == curSection.getPoolEntriesSym().end()) {
       // cout << "Adding " << sym << " to pool of section " << curSection.getName() << endl;
-      curSection.addPoolEntry(sym);
+      curSection.addPoolEntrySym(sym);
     }
   }
 
@@ -98,7 +96,7 @@ int processCommandSymbol(arg* a, command* cmnd) {
 
 // Directives will write literal's value in place during the second cycle no matter the literal's length (during parsing we limited the lit to 32b, aka sizeof(int)).
 // Instructions will do the same if the literal is shorter than 12b, otherwise they will add it to the section's pool here.  
-int processCommandLiteral(arg* a, command* cmnd) {
+int Assembler::processCommandLiteral(arg* a, command* cmnd) {
   if (!cmnd->isDirective && ((uint)a->lit >= maxLit)) {
     if (a->type == 2) {
       fprintf(stderr, "ERROR: Can't use literals longer than 12b with syntax: [reg + literal]");
@@ -114,15 +112,15 @@ int processCommandLiteral(arg* a, command* cmnd) {
 
 
 // Updates locCounter throughout assembler's first cycle.
-void updateLocCounter(command* cmnd) {
+void Assembler::updateLocCounter(command* cmnd) {
   // Directives .skip and .word are the only ones that allocate space:
   if (cmnd->isDirective) {
     // Skip allocates given number of bytes:
-    if (strcmp(cmnd->name, "skip") == 0 && cmnd->args) {
+    if (cmnd->mnemonic == DIR_SKIP && cmnd->args) {
       locCounter += (uint)cmnd->args->lit;
     } 
     // Word allocates 4 bytes per argument:
-    else if (strcmp(cmnd->name, "word") == 0) {
+    else if (cmnd->mnemonic == DIR_WORD) {
       arg* a = cmnd->args;
       while (a) {
         locCounter += 4;
@@ -132,31 +130,67 @@ void updateLocCounter(command* cmnd) {
   }
   // All machine instructions allocate 4 bytes: (but some asembler instructions will consist of more than one machine instructions)
   else {
-    if (strcmp(cmnd->name, "iret") == 0) locCounter += 4;
-    else if (strcmp(cmnd->name, "ld") == 0 && ((cmnd->args->type == 6 || cmnd->args->type == 7))) locCounter += 4;
+    if (cmnd->mnemonic == MN_IRET) locCounter += 4;
+    else if (cmnd->mnemonic == MN_LD && ((cmnd->args->type == 6 || cmnd->args->type == 7))) locCounter += 4;
     locCounter += 4;
   }
 }
 
 
-// Assembler's first cycle: (filling up SymbolTable, SectionTables (and their poolEntries) whilst increasing locationCounter)
-int firstCycle() {
-  // Iterate through parsed commands:
-  command* cmnd = commandsHead;
-  while (cmnd) {
-    if (processCommandLabels(cmnd->labs) == -1) return -1;
+// Labels, symbols and literals of a command: (SymbolTable entries, sections and their poolEntries)
+int Assembler::processCommand(command* cmnd) {
+  if (processCommandLabels(cmnd->labs) == -1) return -1;
 
-    arg* a = cmnd->args;
-    while (a) {
-      if (a->sym) {
-        if (processCommandSymbol(a, cmnd) == -1) return -1;
-      }
-      else if (a->lit) {
-        if (processCommandLiteral(a, cmnd) == -1) return -1;
-      }
+  arg* a = cmnd->args;
+  while (a) {
+    if (a->sym) {
+      if (processCommandSymbol(a, cmnd) == -1) return -1;
+    }
+    else if (a->lit) {
+      if (processCommandLiteral(a, cmnd) == -1) return -1;
+    }
+
+    a = a->next; 
+  }
+
+  return 0;
+}
+
+// Adds the section that just ended to Section Table:
+//  with '--single-pass' its machine instructions are already written, so its pool is placed right away
+//  and the instructions and relocations that address the pool are patched.
+void Assembler::endSection() {
+  curSection.setLength(locCounter);
+
+  if (singlePassOption) {
+    curSection.finalizeLiteralsTable();
 
-      a = a->next; 
+    for (pair<uint, uint>& fixup : poolFixups) {
+      uint location = locCounter + 4 * fixup.second;
+      curSection.setInstructionDisp(fixup.first, location - (fixup.first + 4));
     }
+    poolFixups.clear();
+
+    vector<pair<uint, uint>> entries = curRelTable.getEntries();
+    for (pair<uint, uint>& entry : entries) {
+      if (entry.second & poolIndexTag) entry.second = locCounter + 4 * (entry.second & ~poolIndexTag);
+    }
+    curRelTable.setEntries(std::move(entries));
+
+    relocationTables.addOrUpdateTable(curSection.getName(), std::move(curRelTable)); 
+    curRelTable = RelocationTable();
+  }
+
+  sectionTable.addSection(curSection.getName(), std::move(curSection));
+}
+
+
+// Assembler's first cycle: (filling up SymbolTable, SectionTables (and their poolEntries) whilst increasing locationCounter)
+int Assembler::firstCycle(command* commands) {
+  // Iterate through parsed commands:
+  command* cmnd = commands;
+  while (cmnd) {
+    if (processCommand(cmnd) == -1) return -1;
 
     // Update locCounter: (if the command generates content)
     updateLocCounter(cmnd);
@@ -165,8 +199,7 @@ int firstCycle() {
   }
 
   // Add the last section to Section Table:
-  curSection.setLength(locCounter);
-  sectionTable.addSection(curSection.getName(), curSection);
+  endSection();
 
   return 0;
 }
@@ -196,49 +229,56 @@ bool isReg(char* reg) {
   return isGPR(reg) || isCSR(reg);
 }
 
-char getRegId(char* reg) {
+uint getRegId(char* reg) {
   int len = strlen(reg);
 
   if (len == 2) {
-    if (strcmp(reg, "sp") == 0) return 'E';
-    else if (strcmp(reg, "pc") == 0) return 'F';
-    else return reg[1];
+    if (strcmp(reg, "sp") == 0) return 14;
+    else if (strcmp(reg, "pc") == 0) return 15;
+    else return reg[1] - '0';
   }
   else if (len == 3) {
-    if (reg[2] == '0') return 'A';
-    else if (reg[2] == '1') return 'B';
-    else if (reg[2] == '2') return 'C';
-    else if (reg[2] == '3') return 'D';
-    else if (reg[2] == '4') return 'E';
-    else if (reg[2] == '5') return 'F';
+    return 10 + reg[2] - '0';   // r10 - r15
   }
-  else if (strcmp(reg, "status") == 0) return '0';
-  else if (strcmp(reg, "handler") == 0) return '1';
-  else if (strcmp(reg, "cause") == 0) return '2';
+  else if (strcmp(reg, "status") == 0) return 0;
+  else if (strcmp(reg, "handler") == 0) return 1;
+  else if (strcmp(reg, "cause") == 0) return 2;
 
-  return '?';
+  return 0;
 }
 
-string intToHex(uint num, uint hexLen) {
-  ostringstream ss;
-  ss << uppercase << setfill('0') << std::setw(hexLen) << hex << num;
-  return ss.str();
+uint encodeInstruction(uint op, uint mode, uint regA, uint regB, uint regC, uint disp) {
+  return (op << 28) | (mode << 24) | (regA << 20) | (regB << 16) | (regC << 12) | (disp & 0xfff);
 }
 
+// Disp from the current pc value (start of the next machineInstr) to the pool location where a literal's or symbol's value is:
+//  (with '--single-pass' the location is still the entry's index in the pool, endSection patches the disp)
+uint Assembler::poolDisp(uint location) {
+  curSection.addPoolRef(locCounter);
 
-// Writes machine instructions into the section's content (and checks for correct syntax). 
-//  Fills the section's relocation table when needed.
-int secondCycle() {
-  locCounter = 0;
-  curSection = *sectionTable.lookFor("UND");
+  if (singlePassOption) {
+    poolFixups.push_back(make_pair(locCounter, location));
+    return 0;
+  }
+  return location - (locCounter + 4);
+}
 
-  command* cmnd = commandsHead;
-  while (cmnd) {
-    // For directives, parser made sure that there can't be any %,[,] and other unexpected syntaxes. Only lit or symName.
-    //  But not every directive allows both lit and symNames as its args, nor does every directive allow optional number of args.
-    if (cmnd->isDirective) {
+// Relocation entry for the symbol's value in the pool:
+void Assembler::addPoolRelocation(uint sym, uint location) {
+  if (singlePassOption) location |= poolIndexTag;
+  curRelTable.addEntry(sym, location);
+}
+
+
+// Writes a command's machine instructions into the section's content (and checks for correct syntax). 
+//  Fills the section's relocation table when needed.
+int Assembler::assembleCommand(command* cmnd) {
+  // For directives, parser made sure that there can't be any %,[,] and other unexpected syntaxes. Only lit or symName.
+  //  But not every directive allows both lit and symNames as its args, nor does every directive allow optional number of args.
+  if (cmnd->isDirective) {
+    switch (cmnd->mnemonic) {
       // SKIP:
-      if (strcmp(cmnd->name, "skip") == 0) {
+      case DIR_SKIP: {
         // Check for irregular formats:
         if (!cmnd->args || cmnd->args->next || cmnd->args->sym) {
           fprintf(stderr, "\nERROR: directive .skip expects a single literal as its argument.");
@@ -247,10 +287,11 @@ int secondCycle() {
 
         // No need to write zeros in the section content, it's already initialized with zeros.
         locCounter += (uint)cmnd->args->lit;
+        break;
       }
 
       // WORD:
-      else if (strcmp(cmnd->name, "word") == 0) {
+      case DIR_WORD: {
         if (!cmnd->args) {
           fprintf(stderr, "\nERROR: directive .word expects at least one argument.");
           return -1;
@@ -264,36 +305,41 @@ int secondCycle() {
           }
           else {
             // Create a RealocationTableEntry for 4 bytes starting from the current value of locCounter.
-            curRelTable.addEntry(a->sym, locCounter);
+            curRelTable.addEntry(stringTable.intern(a->sym), locCounter);
           }  
 
           locCounter += 4;
           a = a->next;
         }
+        break;
       }
 
       // SECTION:
-      else if (strcmp(cmnd->name, "section") == 0) {
+      case DIR_SECTION: {
         if (!cmnd->args || !cmnd->args->sym || cmnd->args->next) {
           fprintf(stderr, "\nERROR: directive .section expects a single identifier as its argument.");
           return -1;
         }
 
+        // With '--single-pass' the section was already started by processCommandSymbol:
+        if (singlePassOption) break;
+
         // Add previous section's relocation table to the map of relocation tables:
-        relocationTables.addOrUpdateTable(curSection.getName(), curRelTable); 
+        relocationTables.addOrUpdateTable(curSection.getName(), std::move(curRelTable)); 
         // Start a new Relocation table:
         curRelTable = RelocationTable();
 
         // Write the updated version of the previous section to the SectionTable map instead of the old one.
-        sectionTable.updateSection(curSection);
+        sectionTable.updateSection(std::move(curSection));
 
         // Grab the newly started section:
         locCounter = 0;
-        curSection = *sectionTable.lookFor(cmnd->args->sym);
+        curSection = *sectionTable.lookFor(stringTable.intern(cmnd->args->sym));
+        break;
       }
 
       // OTHER: GLOBAL, EXTERN  (only check if the args are as expected, no additional work)
-      else if (strcmp(cmnd->name, "global") == 0 || strcmp(cmnd->name, "extern") == 0) {
+      case DIR_GLOBAL: case DIR_EXTERN: {
         if (!cmnd->args) {
           fprintf(stderr, "\nERROR: directive .%s must be given one or more symbol arguments.", cmnd->name);
           return -1;
@@ -307,51 +353,52 @@ int secondCycle() {
           }
           a = a->next;
         }
+        break;
       }
 
       // UNRECOGNIZED: (throw an error)
-      else {
+      default: {
         fprintf(stderr, "\nERROR: Unrecognized directive '.%s'", cmnd->name);
         return -1;
       }
     }
+  }
 
-    // INSTRUCTIONS:
-    else {
-      string machineInstr;
-      
+  // INSTRUCTIONS:
+  else {
+    uint machineInstr = 0;
+    const MnemonicInfo* info = cmnd->info;  // Opcode and modes. (nullptr for unrecognized instructions)
+
+    switch (cmnd->mnemonic) {
       // HALT, INT, RET: (no arg)
-      if (strcmp(cmnd->name, "halt") == 0 
-      || strcmp(cmnd->name, "int") == 0
-      || strcmp(cmnd->name, "ret") == 0) {
+      case MN_HALT: case MN_INT: case MN_RET: {
         if (cmnd->args) {
           fprintf(stderr, "\nERROR: Instruction %s can't have arguments.", cmnd->name);
           return -1;
         }
 
-        if (strcmp(cmnd->name, "halt") == 0) machineInstr = "00000000";
-        else if (strcmp(cmnd->name, "int") == 0) machineInstr = "10000000";
-        else machineInstr = "93FE0004";
+        if (cmnd->mnemonic == MN_RET) machineInstr = encodeInstruction(info->op, info->mode, 15, 14, 0, 4);  // pop pc
+        else machineInstr = encodeInstruction(info->op, info->mode, 0, 0, 0, 0);
+        break;
       }
 
       // IRET: (no arg, two machine instr)
-      else if (strcmp(cmnd->name, "iret") == 0) {
+      case MN_IRET: {
         if (cmnd->args) {
           fprintf(stderr, "\nERROR: Instruction %s can't have arguments.", cmnd->name);
           return -1;
         }
 
-        machineInstr = "960E0004";
+        machineInstr = encodeInstruction(info->op, info->mode, 0, 14, 0, 4);  // status <= mem[sp + 4]
         curSection.addContentInstruction(locCounter, machineInstr);
         locCounter += 4;
 
-        machineInstr = "93FE0008";
+        machineInstr = encodeInstruction(info->op, info->memMode, 15, 14, 0, 8);  // pop pc, sp += 8
+        break;
       }
 
       // PUSH, POP, NOT: (one arg: gpr)
-      else if (strcmp(cmnd->name, "push") == 0 
-      || strcmp(cmnd->name, "pop") == 0
-      || strcmp(cmnd->name, "not") == 0) {
+      case MN_PUSH: case MN_POP: case MN_NOT: {
         if (!cmnd->args || !cmnd->args->reg || cmnd->args->next || cmnd->args->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects a single GPR register argument.", cmnd->name);
           return -1;
@@ -361,38 +408,16 @@ int secondCycle() {
           return -1;
         }
 
-        if (strcmp(cmnd->name, "push") == 0) {
-          machineInstr = "81E0";
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "FFC";
-        }
-        else if (strcmp(cmnd->name, "pop") == 0) {
-          machineInstr = "93";
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += 'E';
-          machineInstr += "0004";
-        }
-        else {
-          machineInstr = "60";
-          char regId = getRegId(cmnd->args->reg);
-          machineInstr += regId;
-          machineInstr += regId;
-          machineInstr += "0000";
-        }
+        uint regId = getRegId(cmnd->args->reg);
+        if (cmnd->mnemonic == MN_PUSH) machineInstr = encodeInstruction(info->op, info->mode, 14, 0, regId, 0xffc);
+        else if (cmnd->mnemonic == MN_POP) machineInstr = encodeInstruction(info->op, info->mode, regId, 14, 0, 4);
+        else machineInstr = encodeInstruction(info->op, info->mode, regId, regId, 0, 0);
+        break;
       }
 
       // XCHG, ADD, SUB, MUL, DIV
       // AND, OR, XOR, SHL, SHR: (two args: gpr gpr)
-      else if (strcmp(cmnd->name, "xchg") == 0
-      || strcmp(cmnd->name, "add") == 0
-      || strcmp(cmnd->name, "sub") == 0
-      || strcmp(cmnd->name, "mul") == 0
-      || strcmp(cmnd->name, "div") == 0
-      || strcmp(cmnd->name, "and") == 0
-      || strcmp(cmnd->name, "or") == 0
-      || strcmp(cmnd->name, "xor") == 0
-      || strcmp(cmnd->name, "shl") == 0
-      || strcmp(cmnd->name, "shr") == 0) {
+      case MN_XCHG: case MN_ADD: case MN_SUB: case MN_MUL: case MN_DIV: case MN_AND: case MN_OR: case MN_XOR: case MN_SHL: case MN_SHR: {
         if (!cmnd->args || !cmnd->args->reg || !cmnd->args->next || !cmnd->args->next->reg || cmnd->args->next->next
         || cmnd->args->type != 0 || cmnd->args->next->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects two GPR registers as its arguments.", cmnd->name);
@@ -407,32 +432,16 @@ int secondCycle() {
           return -1;
         }
 
-        if (strcmp(cmnd->name, "xchg") == 0) {
-          machineInstr = "400";
-          machineInstr += getRegId(cmnd->args->next->reg);
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "000";
-        }
-        else {
-          if (strcmp(cmnd->name, "add") == 0) machineInstr = "50";
-          else if (strcmp(cmnd->name, "sub") == 0) machineInstr = "51";
-          else if (strcmp(cmnd->name, "mul") == 0) machineInstr = "52";
-          else if (strcmp(cmnd->name, "div") == 0) machineInstr = "53";
-          else if (strcmp(cmnd->name, "and") == 0) machineInstr = "61";
-          else if (strcmp(cmnd->name, "or") == 0) machineInstr = "62";
-          else if (strcmp(cmnd->name, "xor") == 0) machineInstr = "63";
-          else if (strcmp(cmnd->name, "shl") == 0) machineInstr = "70";
-          else if (strcmp(cmnd->name, "shr") == 0) machineInstr = "71";
-
-          machineInstr += getRegId(cmnd->args->next->reg);
-          machineInstr += getRegId(cmnd->args->next->reg);
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "000";
-        }
+        uint regS = getRegId(cmnd->args->reg);
+        uint regD = getRegId(cmnd->args->next->reg);
+
+        if (cmnd->mnemonic == MN_XCHG) machineInstr = encodeInstruction(info->op, info->mode, 0, regD, regS, 0);
+        else machineInstr = encodeInstruction(info->op, info->mode, regD, regD, regS, 0);
+        break;
       }
 
       // CSRRD: (two args: csr, gpr)
-      else if (strcmp(cmnd->name, "csrrd") == 0) {
+      case MN_CSRRD: {
         if (!cmnd->args || !cmnd->args->reg || !cmnd->args->next || !cmnd->args->next->reg || cmnd->args->next->next
         || cmnd->args->type != 0 || cmnd->args->next->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects a CSR and a GPR register as its arguments.", cmnd->name);
@@ -447,14 +456,12 @@ int secondCycle() {
           return -1;
         }
 
-        machineInstr = "90";
-        machineInstr += getRegId(cmnd->args->next->reg);
-        machineInstr += getRegId(cmnd->args->reg);
-        machineInstr += "0000";
+        machineInstr = encodeInstruction(info->op, info->mode, getRegId(cmnd->args->next->reg), getRegId(cmnd->args->reg), 0, 0);
+        break;
       }
 
       // CSRWR: (two args: gpr, csr)
-      else if (strcmp(cmnd->name, "csrwr") == 0) {
+      case MN_CSRWR: {
         if (!cmnd->args || !cmnd->args->reg || !cmnd->args->next || !cmnd->args->next->reg || cmnd->args->next->next
         || cmnd->args->type != 0 || cmnd->args->next->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects a GPR and a CSR register as its arguments.", cmnd->name);
@@ -469,15 +476,12 @@ int secondCycle() {
           return -1;
         }
 
-        machineInstr = "94";
-        machineInstr += getRegId(cmnd->args->next->reg);
-        machineInstr += getRegId(cmnd->args->reg);
-        machineInstr += "0000";
+        machineInstr = encodeInstruction(info->op, info->mode, getRegId(cmnd->args->next->reg), getRegId(cmnd->args->reg), 0, 0);
+        break;
       }
 
       // CALL, JMP: (one arg: operand)
-      else if (strcmp(cmnd->name, "call") == 0
-      || strcmp(cmnd->name, "jmp") == 0) {
+      case MN_CALL: case MN_JMP: {
         if (!cmnd->args || cmnd->args->next) {
           fprintf(stderr, "\nERROR: Instruction %s expects a single operand as its arguments.", cmnd->name);
           return -1;
@@ -495,60 +499,38 @@ int secondCycle() {
         // 0 - %reg, 1 - [%reg], 2 - [%reg + literal], 3 - [%reg + symbol] (first cycle doesn't allow this one)
         // 4 - $literal, 5 - $symbol, 6 - literal, 7 - symbol   (jmp,br,call use 6,7 instead of 4,5. there are no mem[sym] or mem[lit])
         int argType = cmnd->args->type;
+        uint op = info->op;
+        uint mode = (argType == 0 || (argType == 6 && (uint)cmnd->args->lit < maxLit)) ? info->mode : info->memMode;
 
-        if (argType == 0 || (argType == 6 && (uint)cmnd->args->lit < maxLit)) {
-          if (strcmp(cmnd->name, "call") == 0) machineInstr = "20";
-          else if (strcmp(cmnd->name, "jmp") == 0) machineInstr = "30";
-        }
-        else {
-          if (strcmp(cmnd->name, "call") == 0) machineInstr = "21";
-          else if (strcmp(cmnd->name, "jmp") == 0) machineInstr = "38";
-        }
-
-        if (argType == 0) {
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "00000";   
-        }
-        else if (argType == 1) {
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "00000";
+        if (argType == 0 || argType == 1) {
+          machineInstr = encodeInstruction(op, mode, getRegId(cmnd->args->reg), 0, 0, 0);
         }
         else if (argType == 2) {
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "00";
-          machineInstr += intToHex(cmnd->args->lit, 3);
+          machineInstr = encodeInstruction(op, mode, getRegId(cmnd->args->reg), 0, 0, cmnd->args->lit);
         }
         else if (argType == 6) {
           // Literal is in the pool:
           if ((uint)cmnd->args->lit >= maxLit) {
-            uint dispToLit = curSection.getPoolEntryLocation(cmnd->args->lit); // Disp from the start of this section to the pool loc.
-            dispToLit = dispToLit - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the literal's value is. 
-            machineInstr += "F00";  // gpr[A]=pc
-            machineInstr += intToHex(dispToLit, 3);
+            uint dispToLit = poolDisp(curSection.getPoolEntryLocation(cmnd->args->lit));
+            machineInstr = encodeInstruction(op, mode, 15, 0, 0, dispToLit);  // gpr[A]=pc
           }
           // Literal isn't in the pool:
           else {
-            machineInstr += "000";  // gpr[A]=r0=0
-            machineInstr += intToHex(cmnd->args->lit, 3);
+            machineInstr = encodeInstruction(op, mode, 0, 0, 0, cmnd->args->lit);  // gpr[A]=r0=0
           }
         }
         else if (argType == 7) {
-          if (strcmp(cmnd->name, "call") == 0) machineInstr += "F00";
-          else if (strcmp(cmnd->name, "jmp") == 0) machineInstr += "F00";
-
-          uint dispToSymVal = curSection.getPoolEntryLocation(cmnd->args->sym); // Disp from the start of this section to the pool loc.
-
-          curRelTable.addEntry(cmnd->args->sym, dispToSymVal);  // Add a relocation entry to the section's relocation table.
-
-          dispToSymVal = dispToSymVal - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the symbol's value is. 
-          machineInstr += intToHex(dispToSymVal, 3);
+          uint sym = stringTable.intern(cmnd->args->sym);
+          uint location = curSection.getPoolEntrySymLocation(sym); // Disp from the start of this section to the pool loc.
+          addPoolRelocation(sym, location);  // Add a relocation entry to the section's relocation table.
+          uint dispToSymVal = poolDisp(location);
+          machineInstr = encodeInstruction(op, mode, 15, 0, 0, dispToSymVal);  // gpr[A]=pc
         }
+        break;
       }
 
       // BRANCH: (three args: gpr, gpr, operand)
-      else if (strcmp(cmnd->name, "beq") == 0
-      || strcmp(cmnd->name, "bne") == 0
-      || strcmp(cmnd->name, "bgt") == 0) {
+      case MN_BEQ: case MN_BNE: case MN_BGT: {
         if (!cmnd->args || !cmnd->args->next || !cmnd->args->next->next || cmnd->args->next->next->next
         || !cmnd->args->reg || !cmnd->args->next->reg || cmnd->args->type != 0 || cmnd->args->next->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects the following arguments: gpr, gpr, operand.", cmnd->name);
@@ -570,69 +552,42 @@ int secondCycle() {
         } 
 
         int argType = cmnd->args->next->next->type;
-        char* reg1 = cmnd->args->reg;
-        char* reg2 = cmnd->args->next->reg;
-        
+        uint reg1 = getRegId(cmnd->args->reg);
+        uint reg2 = getRegId(cmnd->args->next->reg);
+      
         // 0 - %reg, 1 - [%reg], 2 - [%reg + literal], 3 - [%reg + symbol] (first cycle doesn't allow this one)
         // 4 - $literal, 5 - $symbol, 6 - literal, 7 - symbol   (jmp,br,call use 6,7 instead of 4,5. there are no mem[sym] or mem[lit])
-        machineInstr = "3";
-
-        if (argType == 0 || (argType == 6 && (uint)cmnd->args->next->next->lit < maxLit)) {
-          if (strcmp(cmnd->name, "beq") == 0) machineInstr += "1";
-          else if (strcmp(cmnd->name, "bne") == 0) machineInstr += "2";
-          else machineInstr += "3";
-        }
-        else {
-          if (strcmp(cmnd->name, "beq") == 0) machineInstr += "9";
-          else if (strcmp(cmnd->name, "bne") == 0) machineInstr += "A";
-          else machineInstr += "B";
-        }
+        uint mode = (argType == 0 || (argType == 6 && (uint)cmnd->args->next->next->lit < maxLit)) ? info->mode : info->memMode;
 
         if (argType == 0 || argType == 1) {
-          machineInstr += getRegId(cmnd->args->next->next->reg);
-          machineInstr += getRegId(reg1);
-          machineInstr += getRegId(reg2);
-          machineInstr += "000";   
+          machineInstr = encodeInstruction(info->op, mode, getRegId(cmnd->args->next->next->reg), reg1, reg2, 0);
         }
         else if (argType == 2) {
-          machineInstr += getRegId(cmnd->args->next->next->reg);
-          machineInstr += getRegId(reg1);
-          machineInstr += getRegId(reg2);
-          machineInstr += intToHex(cmnd->args->next->next->lit, 3);
+          machineInstr = encodeInstruction(info->op, mode, getRegId(cmnd->args->next->next->reg), reg1, reg2, cmnd->args->next->next->lit);
         }
         else if (argType == 6) {
           // Literal is in the pool:
           if ((uint)cmnd->args->next->next->lit >= maxLit) {
-            uint dispToLit = curSection.getPoolEntryLocation(cmnd->args->next->next->lit); // Disp from the start of this section to the pool loc.
-            dispToLit = dispToLit - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the literal's value is. 
-            machineInstr += "F";  // gpr[A]=pc
-            machineInstr += getRegId(reg1);
-            machineInstr += getRegId(reg2);
-            machineInstr += intToHex(dispToLit, 3);
+            uint dispToLit = poolDisp(curSection.getPoolEntryLocation(cmnd->args->next->next->lit));
+            machineInstr = encodeInstruction(info->op, mode, 15, reg1, reg2, dispToLit);  // gpr[A]=pc
           }
           // Literal isn't in the pool:
           else {
-            machineInstr += "0";  // gpr[A]=r0=0
-            machineInstr += getRegId(reg1);
-            machineInstr += getRegId(reg2);
-            machineInstr += intToHex(cmnd->args->next->next->lit, 3);
+            machineInstr = encodeInstruction(info->op, mode, 0, reg1, reg2, cmnd->args->next->next->lit);  // gpr[A]=r0=0
           }
         }
         else if (argType == 7) {
-          uint dispToSym = curSection.getPoolEntryLocation(cmnd->args->next->next->sym); // Disp from the start of this section to the pool loc.
-          
-          curRelTable.addEntry(cmnd->args->next->next->sym, dispToSym);  // Add a relocation entry to the section's relocation table.
-          
-          dispToSym = dispToSym - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the symbol's value is. 
-          machineInstr += "F";  // gpr[A]=pc
-          machineInstr += getRegId(reg1);
-          machineInstr += getRegId(reg2);
-          machineInstr += intToHex(dispToSym, 3);
+          uint sym = stringTable.intern(cmnd->args->next->next->sym);
+          uint location = curSection.getPoolEntrySymLocation(sym); // Disp from the start of this section to the pool loc.
+          addPoolRelocation(sym, location);  // Add a relocation entry to the section's relocation table.
+          uint dispToSym = poolDisp(location);
+          machineInstr = encodeInstruction(info->op, mode, 15, reg1, reg2, dispToSym);  // gpr[A]=pc
         }
+        break;
       }
 
       // LD: (two args: operand, gpr)
-      else if (strcmp(cmnd->name, "ld") == 0) {
+      case MN_LD: {
         if (!cmnd->args || !cmnd->args->next || !cmnd->args->next->reg || cmnd->args->next->next || cmnd->args->next->type != 0) {
           fprintf(stderr, "\nERROR: Instruction %s expects an operand (but not a CSR) and a GPR as its arguments.", cmnd->name);
           return -1;
@@ -644,72 +599,49 @@ int secondCycle() {
         } 
 
         int argType = cmnd->args->type;
-        char* reg = cmnd->args->next->reg;
+        uint reg = getRegId(cmnd->args->next->reg);
         // 0 - %reg, 1 - [%reg], 2 - [%reg + literal], 3 - [%reg + symbol] (first cycle doesn't allow this one)
         // 4 - $literal, 5 - $symbol, 6 - literal, 7 - symbol   
         // pazi, sada 4 i 5 rade ono sto su gore radili 6 i 7!
         if (argType == 0) {
-          machineInstr = "91";
-          machineInstr += getRegId(reg);
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "0000";   
+          machineInstr = encodeInstruction(info->op, info->mode, reg, getRegId(cmnd->args->reg), 0, 0);
         }
         else if (argType == 1) {
-          machineInstr = "92";
-          machineInstr += getRegId(reg);
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "0000"; 
+          machineInstr = encodeInstruction(info->op, info->memMode, reg, getRegId(cmnd->args->reg), 0, 0);
         }
         else if (argType == 2) {
-          machineInstr = "92";
-          machineInstr += getRegId(reg);
-          machineInstr += getRegId(cmnd->args->reg);
-          machineInstr += "0";
-          machineInstr += intToHex(cmnd->args->lit, 3);
+          machineInstr = encodeInstruction(info->op, info->memMode, reg, getRegId(cmnd->args->reg), 0, cmnd->args->lit);
         }
         // 1) gpr[A] <= $literal
         else if (argType == 4 || argType == 6) {
           if ((uint)cmnd->args->lit >= maxLit) {    
-            machineInstr = "92";
-            machineInstr += getRegId(reg);
-            machineInstr += "F0"; // gpr[B]=pc=15
-            uint dispToLit = curSection.getPoolEntryLocation(cmnd->args->lit); // Disp from the start of this section to the pool loc.
-            dispToLit = dispToLit - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the literal's value is. 
-            machineInstr += intToHex(dispToLit, 3);    
+            uint dispToLit = poolDisp(curSection.getPoolEntryLocation(cmnd->args->lit));
+            machineInstr = encodeInstruction(info->op, info->memMode, reg, 15, 0, dispToLit);  // gpr[B]=pc=15
           }
           else {
-            machineInstr = "91";
-            machineInstr += getRegId(reg);  
-            machineInstr += "00"; // gpr[B]=r0=0
-            machineInstr += intToHex(cmnd->args->lit, 3); 
+            machineInstr = encodeInstruction(info->op, info->mode, reg, 0, 0, cmnd->args->lit);  // gpr[B]=r0=0
           }
         }
         // 1) gpr[A] <= $symbol
         else if (argType == 5 || argType == 7) {    
-          machineInstr = "92";
-          machineInstr += getRegId(reg);
-          machineInstr += "F0"; // gpr[B]=pc=15
-          uint dispToSymVal = curSection.getPoolEntryLocation(cmnd->args->sym); // Disp from the start of this section to the pool loc.
-        
-          curRelTable.addEntry(cmnd->args->sym, dispToSymVal);  // Add a relocation entry to the section's relocation table.
-        
-          dispToSymVal = dispToSymVal - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the symbol's value is. 
-          machineInstr += intToHex(dispToSymVal, 3);
+          uint sym = stringTable.intern(cmnd->args->sym);
+          uint location = curSection.getPoolEntrySymLocation(sym); // Disp from the start of this section to the pool loc.
+          addPoolRelocation(sym, location);  // Add a relocation entry to the section's relocation table.
+          uint dispToSymVal = poolDisp(location);
+          machineInstr = encodeInstruction(info->op, info->memMode, reg, 15, 0, dispToSymVal);  // gpr[B]=pc=15
         }
         // 2) gpr[A] <= mem[gpr[A]]
         if (argType == 6 || argType == 7) {
           curSection.addContentInstruction(locCounter, machineInstr);
           locCounter += 4;
-          
-          machineInstr = "92";
-          machineInstr += getRegId(reg);
-          machineInstr += getRegId(reg); // gpr[B]=gpr[A]
-          machineInstr += "0000"; 
+        
+          machineInstr = encodeInstruction(info->op, info->memMode, reg, reg, 0, 0);  // gpr[B]=gpr[A]
         }
+        break;
       }
 
       // ST: (two args: gpr, operand)
-      else if (strcmp(cmnd->name, "st") == 0) {
+      case MN_ST: {
         if (!cmnd->args || !cmnd->args->next || !cmnd->args->reg || cmnd->args->next->next) {
           fprintf(stderr, "\nERROR: Instruction %s expects a GPR and an operand as its arguments.", cmnd->name);
           return -1;
@@ -721,7 +653,7 @@ int secondCycle() {
         } 
 
         int argType = cmnd->args->next->type;
-        char* reg = cmnd->args->reg;
+        uint reg = getRegId(cmnd->args->reg);
         // 0 - %reg, 1 - [%reg], 2 - [%reg + literal], 3 - [%reg + symbol] (first cycle doesn't allow this one)
         // 4 - $literal, 5 - $symbol, 6 - literal, 7 - symbol   
         // pazi, sada 4 i 5 rade ono sto su gore radili 6 i 7!
@@ -731,175 +663,271 @@ int secondCycle() {
           return -1;
         }
         else if (argType == 1) {
-          machineInstr = "80";
-          machineInstr += getRegId(cmnd->args->next->reg);
-          machineInstr += "0";
-          machineInstr += getRegId(reg);
-          machineInstr += "000"; 
+          machineInstr = encodeInstruction(info->op, info->mode, getRegId(cmnd->args->next->reg), 0, reg, 0);
         }
         else if (argType == 2) {
-          machineInstr = "80";
-          machineInstr += getRegId(cmnd->args->next->reg);
-          machineInstr += "0";
-          machineInstr += getRegId(reg);
-          machineInstr += intToHex(cmnd->args->next->lit, 3);
+          machineInstr = encodeInstruction(info->op, info->mode, getRegId(cmnd->args->next->reg), 0, reg, cmnd->args->next->lit);
         }
         else if (argType == 6) {
           if ((uint)cmnd->args->next->lit >= maxLit) {     
-            machineInstr = "82";
-            machineInstr += "F0"; // gpr[A]=pc=15, gpr[B]=r0=0
-            machineInstr += getRegId(reg);  // gpr[C]=reg
-            uint dispToLit = curSection.getPoolEntryLocation(cmnd->args->next->lit); // Disp from the start of this section to the pool loc.
-            dispToLit = dispToLit - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the literal's value is. 
-            machineInstr += intToHex(dispToLit, 3);      
+            uint dispToLit = poolDisp(curSection.getPoolEntryLocation(cmnd->args->next->lit));
+            machineInstr = encodeInstruction(info->op, info->memMode, 15, 0, reg, dispToLit);  // gpr[A]=pc=15, gpr[B]=r0=0, gpr[C]=reg
           }
           else {
-            machineInstr = "80";
-            machineInstr += "00"; // gpr[A]=r0=0, gpr[B]=r0=0
-            machineInstr += getRegId(reg);  // gpr[C]=reg
-            machineInstr += intToHex(cmnd->args->next->lit, 3); 
+            machineInstr = encodeInstruction(info->op, info->mode, 0, 0, reg, cmnd->args->next->lit);  // gpr[A]=r0=0, gpr[B]=r0=0, gpr[C]=reg
           }
         } 
         else if (argType == 7) {
-          machineInstr = "82";
-          machineInstr += "F0"; // gpr[A]=pc=15, gpr[B]=r0=0
-          machineInstr += getRegId(reg);  // gpr[C]=reg
-          uint dispToSymVal = curSection.getPoolEntryLocation(cmnd->args->next->sym); // Disp from the start of this section to the pool loc.
-        
-          curRelTable.addEntry(cmnd->args->next->sym, dispToSymVal);  // Add a relocation entry to the section's relocation table.
-        
-          dispToSymVal = dispToSymVal - (locCounter + 4); // Disp from the current pc value (start of the next machineInstr) to the location in the pool where the symbol's value is. 
-          machineInstr += intToHex(dispToSymVal, 3);
+          uint sym = stringTable.intern(cmnd->args->next->sym);
+          uint location = curSection.getPoolEntrySymLocation(sym); // Disp from the start of this section to the pool loc.
+          addPoolRelocation(sym, location);  // Add a relocation entry to the section's relocation table.
+          uint dispToSymVal = poolDisp(location);
+          machineInstr = encodeInstruction(info->op, info->memMode, 15, 0, reg, dispToSymVal);  // gpr[A]=pc=15, gpr[B]=r0=0, gpr[C]=reg
         }
+        break;
       }
 
       // UNRECOGNIZED:
-      else {
+      default: {
         fprintf(stderr, "\nERROR: Unrecognized instruction '%s'", cmnd->name);
         return -1;
       }
-
-      curSection.addContentInstruction(locCounter, machineInstr);
-      locCounter += 4;
     }
 
+    curSection.addContentInstruction(locCounter, machineInstr);
+    locCounter += 4;
+  }
+
+  return 0;
+}
+
+// Assembler's second cycle:
+int Assembler::secondCycle(command* commands) {
+  locCounter = 0;
+  curSection = *sectionTable.lookFor(undId);
 
+  command* cmnd = commands;
+  while (cmnd) {
+    if (assembleCommand(cmnd) == -1) return -1;
     cmnd = cmnd->next;
   }
 
 
-
   // Add previous section's relocation table to the map of relocation tables:
-  relocationTables.addOrUpdateTable(curSection.getName(), curRelTable);
+  relocationTables.addOrUpdateTable(curSection.getName(), std::move(curRelTable));
 
   // Write the updated version of the previous section to the SectionTable map instead of the old one.
-  sectionTable.updateSection(curSection);
+  sectionTable.updateSection(std::move(curSection));
 
   return 0;
 } 
 
 
-// Opening the input '.s' file and the output '.o' file:
-FILE* openInputFile(int argc, char* argv[]) {
-  string prefix = "../tests/";
-  string fileName;
+// Option '--single-pass': both cycles' work on a command as soon as it's parsed.
+int Assembler::assembleParsedCommand(command* cmnd) {
+  if (processCommand(cmnd) == -1) return -1;
+  return assembleCommand(cmnd);
+}
 
-  if (argc == 2) fileName = argv[1];
-  else if (argc == 4 && strcmp("-o", argv[1]) == 0) fileName = argv[3];
-  else {
-    fprintf(stderr, "Error: expected syntax './asembler -o outputName inputName' or './asembler inputName'\n");
-    return nullptr;
-  }
-  
-  string path = prefix + fileName;
-  FILE* inputFile = fopen(path.c_str(), "r");
+
+// Assembles inputPath into the object file outputPath (and its textual form outputPath.txt):
+int Assembler::assemble(const string& inputPath, const string& outputPath) {
+  /// Parse the input file:
+  FILE* inputFile = fopen(inputPath.c_str(), "r");
   if (!inputFile) {
     fprintf(stderr, "Error: Couldn't open the requested inputFile.\n");
+    return -1;
   }
 
-  return inputFile;
-}
-FILE* openOutputFile(int argc, char* argv[]) {
-  string fileName = "../tests/";
-  
-  if (argc == 2) {
-    fileName += argv[1];
-    fileName = fileName.substr(0, fileName.length()-2);  // Removes '.s' suffix
-    fileName += ".o"; 
-  }
-  else if (argc == 4) {
-    fileName += argv[2];
-  }
-  outputFileName = fileName;
-  fileName += ".txt";
-
-  FILE* outputFile = fopen(fileName.c_str(), "w");
-  if (!outputFile) {
-    fprintf(stderr, "Error: Couldn't open the requested outputFile.\n");
-  }
-
-  return outputFile;
-}
+  ParserState parserState;
 
+  // Single pass: the parser hands every command over to be assembled right away.
+  if (singlePassOption) parserState.commandHandler = [this](command* cmnd) { return assembleParsedCommand(cmnd); };
 
+  yyscan_t scanner;
+  yylex_init_extra(&parserState, &scanner);
+  yyset_in(inputFile, scanner);
+  int parseRes = yyparse(scanner, &parserState);
+  yylex_destroy(scanner);
 
+  fclose(inputFile);
 
-int main(int argc, char* argv[]) {
-  /// Parse the input file:
-  FILE* inputFile = openInputFile(argc, argv);
-  if (inputFile == nullptr) return -1;
+  if (singlePassOption) {
+    if (parseRes != 0) {
+      fprintf(stderr, "\n\nStopping the assembler's process due to error.");
+      return -1;
+    }
 
-  yyin = inputFile;
-	yyparse();
+    // Add the last section to Section Table:
+    endSection();
 
-  fclose(inputFile);
+    if (symbolTable.validateSymbolTable(stringTable) == -1) return -1; 
+  }
+  else {
+    if (parseRes != 0) return -1;
 
 
-  /// Assembler's first cycle:
-  if (firstCycle() == -1) return -1;
+    /// Assembler's first cycle:
+    if (firstCycle(parserState.commandsHead) == -1) return -1;
 
 
-  /// Additional work between the two cycles:
-  if (symbolTable.validateSymbolTable() == -1) return -1; 
+    /// Additional work between the two cycles:
+    if (symbolTable.validateSymbolTable(stringTable) == -1) return -1; 
 
-  sectionTable.finalizeLiteralsTables();
+    sectionTable.finalizeLiteralsTables();
 
 
-  /// Assembler's second cycle:
-  if (secondCycle() == -1) {
-    fprintf(stderr, "\n\nStopping the assembler's process due to error.");
-    return -1;
+    /// Assembler's second cycle:
+    if (secondCycle(parserState.commandsHead) == -1) {
+      fprintf(stderr, "\n\nStopping the assembler's process due to error.");
+      return -1;
+    }
   }
 
 
   /// Printing:
-  FILE* outputFile = openOutputFile(argc, argv);
-  if (outputFile == nullptr) return -1;
+  string txtPath = outputPath + ".txt";
+  FILE* outputFile = fopen(txtPath.c_str(), "w");
+  if (!outputFile) {
+    fprintf(stderr, "Error: Couldn't open the requested outputFile.\n");
+    return -1;
+  }
 
-  symbolTable.printSymbolTable(outputFile);
-  sectionTable.printSectionTables(outputFile);
-  relocationTables.printRelocationTables(outputFile);
+  symbolTable.printSymbolTable(outputFile, stringTable);
+  sectionTable.printSectionTables(outputFile, stringTable);
+  relocationTables.printRelocationTables(outputFile, stringTable);
 
   fclose(outputFile);
 
 
   /// Creating a binary output:
-  ofstream out(outputFileName);  
+  ofstream out(outputPath, ios::binary);  
   if (out.fail()) {
     fprintf(stderr, "Asembler Error: couldn't write the binary output in the 'tests' directory.\n");
     return -1;
   }
   
+  bWriteHeader(out, objectFileMagic);
+  stringTable.bWrite(out);
   symbolTable.bWrite(out);
   sectionTable.bWrite(out);
   relocationTables.bWrite(out);
   
   out.close();
 
+  return 0;
+}
 
-  /// Free allocated memory:
-  freeCommands(commandsHead); 
 
+vector<string> inputFileNames;
+string outputName = "";    // Output file, or the output directory in batch mode. ('-o' option)
+bool singlePass = false;   // ('--single-pass' option)
+uint threadCount = 0;      // Batch mode assembles the input files on this many threads. ('-j' option)
 
-	return 0;
-}
\ No newline at end of file
+
+// Remember inputFileNames, outputName and the options:
+int processCommandLineArguments(int argc, char* argv[]) {
+  bool inputErr = false;
+
+  for (int i = 1; i < argc; i++) {
+    // Option '-o':
+    if (strcmp(argv[i], "-o") == 0) {
+      if (i == argc - 1 || argv[i+1][0] == '-' || outputName != "") {
+        inputErr = true;
+        break;
+      }
+      outputName = argv[++i];
+    }
+    // Option '-j':
+    else if (strcmp(argv[i], "-j") == 0) {
+      if (i == argc - 1 || atoi(argv[i+1]) < 1) {
+        inputErr = true;
+        break;
+      }
+      threadCount = atoi(argv[++i]);
+    }
+    // Option '--single-pass':
+    else if (strcmp(argv[i], "--single-pass") == 0) {
+      singlePass = true;
+    }
+    // Input file:
+    else if (argv[i][0] != '-') {
+      inputFileNames.push_back(argv[i]);
+    }
+    else inputErr = true;
+  }
+
+  if (inputErr || inputFileNames.size() == 0) {
+    fprintf(stderr, "Error: expected syntax './asembler [--single-pass] -o outputName inputName' or './asembler [--single-pass] inputName'\n");
+    fprintf(stderr, "  or, for many files, './asembler [--single-pass] [-j threads] [-o outputDir] inputNames...'\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+
+// Assembles every input file, on threadCount threads: (each one gets its own Assembler and parser arenas, only the mnemonic table is shared)
+//  Outputs go to the outputName directory, or next to the inputs if there's no '-o'.
+int assembleBatch(string prefix) {
+  string outputDir = prefix + outputName;
+  if (outputName != "" && mkdir(outputDir.c_str(), 0755) == -1 && errno != EEXIST) {
+    fprintf(stderr, "Error: Couldn't create the output directory %s.\n", outputDir.c_str());
+    return -1;
+  }
+
+  vector<string> outputPaths;
+  unordered_map<string, uint> outputIds;  // To catch two inputs with the same name writing the same output file.
+  for (uint i = 0; i < inputFileNames.size(); i++) {
+    string name = inputFileNames[i].substr(0, inputFileNames[i].length()-2) + ".o";  // Removes '.s' suffix
+    if (outputName != "") name = outputDir + "/" + name.substr(name.find_last_of('/') + 1);
+    else name = prefix + name;
+
+    if (!outputIds.insert(make_pair(name, i)).second) {
+      fprintf(stderr, "Error: Input files %s and %s would both be written to %s.\n", 
+        inputFileNames[outputIds[name]].c_str(), inputFileNames[i].c_str(), name.c_str());
+      return -1;
+    }
+    outputPaths.push_back(name);
+  }
+
+  vector<int> results(inputFileNames.size(), 0);
+  atomic<uint> next(0);
+  auto worker = [&]() {
+    for (uint i = next++; i < inputFileNames.size(); i = next++) {
+      Assembler assembler(singlePass);
+      results[i] = assembler.assemble(prefix + inputFileNames[i], outputPaths[i]);
+    }
+  };
+
+  vector<thread> threads;
+  for (uint t = 1; t < threadCount && t < inputFileNames.size(); t++) {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread& t : threads) t.join();
+
+  int res = 0;
+  for (uint i = 0; i < inputFileNames.size(); i++) {
+    if (results[i] == -1) {
+      fprintf(stderr, "\nError: Couldn't assemble %s.\n", inputFileNames[i].c_str());
+      res = -1;
+    }
+  }
+  return res;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (processCommandLineArguments(argc, argv) == -1) return -1;
+  string prefix = "../tests/";
+
+  // Batch mode: (more than one input file, or a '-j' option)
+  if (inputFileNames.size() > 1 || threadCount > 0) return assembleBatch(prefix);
+
+  string inputPath = prefix + inputFileNames[0];
+  string outputPath = outputName != "" ? prefix + outputName : inputPath.substr(0, inputPath.length()-2) + ".o";  // Removes '.s' suffix
+
+  Assembler assembler(singlePass);
+	return assembler.assemble(inputPath, outputPath);
+}
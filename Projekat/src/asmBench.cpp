@@ -0,0 +1,94 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+
+// Measures the assembler's throughput in lines per second on a generated source: (asmbench [megabytes] [runs])
+//  The source has every kind of instruction and operand, labels, globals, externs and small/large literals,
+//  split into sections short enough for pool displacements to fit in 12 bits.
+ulong writeSource(string fileName, ulong totalSize) {
+  FILE* file = fopen(fileName.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "Error: Couldn't open %s.\n", fileName.c_str());
+    exit(-1);
+  }
+
+  const char* gprs[] = { "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "r13", "sp", "pc" };
+  const char* csrs[] = { "status", "handler", "cause" };
+  const char* arith[] = { "xchg", "add", "sub", "mul", "div", "and", "or", "xor", "shl", "shr" };
+  const char* branches[] = { "beq", "bne", "bgt" };
+  mt19937 rng(12345);
+  ulong size = 0, lines = 0;
+
+  size += fprintf(file, ".extern ext0, ext1, ext2, ext3\n");
+  lines++;
+
+  for (uint sec = 0; size < totalSize; sec++) {
+    size += fprintf(file, ".section sec%u\n.global fun%u\nfun%u:\n", sec, sec, sec);
+    lines += 3;
+
+    for (int i = 0; i < 160; i++) {
+      const char* r1 = gprs[rng() % 14];
+      const char* r2 = gprs[rng() % 14];
+      uint sym = rng() % 4;
+      uint small = rng() % 0x1000;
+      uint large = 0x1000 + rng() % 0x10000;  // Few distinct values, so pools stay short.
+
+      switch (rng() % 12) {
+        case 0:  size += fprintf(file, "  push %%%s\n  pop %%%s\n", r1, r2); lines++; break;
+        case 1:  size += fprintf(file, "  %s %%%s, %%%s\n", arith[rng() % 10], r1, r2); break;
+        case 2:  size += fprintf(file, "  ld $0x%x, %%%s\n", small, r1); break;
+        case 3:  size += fprintf(file, "  ld $0x%x, %%%s\n", large, r1); break;
+        case 4:  size += fprintf(file, "  ld [%%%s + 0x%x], %%%s\n", r1, small, r2); break;
+        case 5:  size += fprintf(file, "  ld ext%u, %%%s\n", sym, r1); break;
+        case 6:  size += fprintf(file, "  st %%%s, [%%%s]\n", r1, r2); break;
+        case 7:  size += fprintf(file, "  st %%%s, 0x%x\n", r1, large); break;
+        case 8:  size += fprintf(file, "  %s %%%s, %%%s, fun%u\n", branches[rng() % 3], r1, r2, sec); break;
+        case 9:  size += fprintf(file, "  call ext%u\n", sym); break;
+        case 10: size += fprintf(file, "  csrrd %%%s, %%%s\n  csrwr %%%s, %%%s\n", csrs[rng() % 3], r1, r2, csrs[rng() % 3]); lines++; break;
+        default: size += fprintf(file, "  not %%%s   # comment\n", r1); break;
+      }
+      lines++;
+    }
+
+    size += fprintf(file, "  ret\n.word 0x%x, fun%u\n", (uint)rng(), sec);
+    lines += 2;
+  }
+
+  fprintf(file, ".end\n");
+  fclose(file);
+  return lines + 1;
+}
+
+
+int main(int argc, char* argv[]) {
+  ulong megabytes = argc > 1 ? atoi(argv[1]) : 8;
+  int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+  string prefix = "../tests/";
+  ulong lines = writeSource(prefix + "asmbench.s", megabytes << 20);
+
+  // Best of the runs:
+  double best = 0;
+  for (int i = 0; i < runs; i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (system("./asembler -o asmbench.o asmbench.s") != 0) {
+      fprintf(stderr, "Error: The assembler failed on the generated source.\n");
+      return -1;
+    }
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (i == 0 || time < best) best = time;
+  }
+
+  printf("%lu MB, %lu lines:\n", megabytes, lines);
+  printf("  asembler: %8.1f ms  (%.0f lines/s)\n", best * 1000, lines / best);
+
+  remove((prefix + "asmbench.s").c_str());
+  remove((prefix + "asmbench.o").c_str());
+  remove((prefix + "asmbench.o.txt").c_str());
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "../inc/binaryFile.hpp"
+
+
+void bWriteHeader(ofstream& file, uint magic) {
+  bWriteUint(file, magic);
+  bWriteUint(file, binaryFileVersion);
+}
+
+int checkHeaderValues(uint magic, uint version, uint expectedMagic, string fileName) {
+  if (magic != expectedMagic) {
+    fprintf(stderr, "Error: %s isn't a%s file, or was made by an older version of the tools.\n", 
+      fileName.c_str(), expectedMagic == objectFileMagic ? "n assembler's output" 
+                        : expectedMagic == archiveMagic ? "n archive" : " linker's output");
+    return -1;
+  }
+  if (version != binaryFileVersion) {
+    fprintf(stderr, "Error: %s has format version %u, expected version %u. Rebuild it with the current tools.\n",
+      fileName.c_str(), version, binaryFileVersion);
+    return -1;
+  }
+  return 0;
+}
+int bCheckHeader(ifstream& file, uint magic, string fileName) {
+  uint fileMagic = bReadUint(file);
+  uint fileVersion = bReadUint(file);
+  if (file.fail()) fileMagic = 0;
+  return checkHeaderValues(fileMagic, fileVersion, magic, fileName);
+}
+int bCheckHeader(const char* image, unsigned long imageSize, uint magic, string fileName) {
+  uint fileMagic = 0, fileVersion = 0;
+  if (imageSize >= binaryFileHeaderSize) {
+    memcpy(&fileMagic, image, sizeof(uint));
+    memcpy(&fileVersion, image + sizeof(uint), sizeof(uint));
+  }
+  return checkHeaderValues(fileMagic, fileVersion, magic, fileName);
+}
+
+
+void bWriteUint(ofstream& file, uint value) {
+  file.write((char*)&value, sizeof(uint));
+}
+void bWriteUlong(ofstream& file, ulong value) {
+  file.write((char*)&value, sizeof(ulong));
+}
+void bWriteString(ofstream& file, const string& s) {
+  bWriteUint(file, s.length());
+  file.write(s.data(), s.length());
+}
+void bWriteBytes(ofstream& file, const vector<char>& bytes) {
+  bWriteUint(file, bytes.size());
+  file.write(bytes.data(), bytes.size());
+}
+
+uint bReadUint(ifstream& file) {
+  uint value = 0;
+  file.read((char*)&value, sizeof(uint));
+  return value;
+}
+ulong bReadUlong(ifstream& file) {
+  ulong value = 0;
+  file.read((char*)&value, sizeof(ulong));
+  return value;
+}
+void bReadString(ifstream& file, string& s) {
+  uint len = bReadUint(file);
+  if (file.fail()) len = 0;
+  s.resize(len);
+  file.read(&s[0], len);
+}
+void bReadBytes(ifstream& file, vector<char>& bytes) {
+  uint len = bReadUint(file);
+  if (file.fail()) len = 0;
+  bytes.resize(len);
+  file.read(bytes.data(), len);
+}
@@ -0,0 +1,121 @@
+#include "../inc/devices.hpp"
+
+
+ulong eventDeadline = (ulong)-1;
+priority_queue<DeviceEvent, vector<DeviceEvent>, greater<DeviceEvent>> events;
+ulong timerGeneration = 0;
+uint pendingInterrupts = 0;  // Bit (1 << cause) for every raised interrupt that wasn't accepted yet.
+
+// Terminal input: (filled by the input thread, drained by INPUT_POLL_EVENTs)
+mutex inputMutex;
+queue<char> inputChars;
+atomic<bool> inputReady(false);
+bool terminalRaw = false;
+struct termios savedTerminal;
+
+
+// Runs on its own thread, so the emulation never waits for input:
+void readTerminalInput() {
+  char c;
+  while (read(STDIN_FILENO, &c, 1) == 1) {
+    lock_guard<mutex> lock(inputMutex);
+    inputChars.push(c);
+    inputReady = true;
+  }
+}
+
+void scheduleTimer() {
+  uint cfg = readWord(timCfg) & 0x7;
+  timerGeneration++;
+  events.push({ instrCount + timerPeriodsMs[cfg] * virtualInstrsPerMs, TIMER_EVENT, timerGeneration });
+  eventDeadline = min(eventDeadline, events.top().when);
+}
+
+void devicesInit() {
+  // Characters should reach the emulated program as they are typed, without being echoed:
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedTerminal) == 0) {
+    struct termios raw = savedTerminal;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    terminalRaw = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+  }
+  thread(readTerminalInput).detach();
+
+  scheduleTimer();
+  events.push({ instrCount + inputPollInstrs, INPUT_POLL_EVENT, 0 });
+  eventDeadline = events.top().when;
+}
+
+void devicesFree() {
+  if (terminalRaw) tcsetattr(STDIN_FILENO, TCSANOW, &savedTerminal);
+  terminalRaw = false;
+}
+
+
+// Moves the next typed character into term_in, unless the previous one wasn't handled yet:
+//  (characters wait until the program sets its interrupt handler)
+void pollTerminalInput() {
+  if (!inputReady || !csr[handler] || (pendingInterrupts & (1 << terminalCause))) return;
+
+  char c;
+  {
+    lock_guard<mutex> lock(inputMutex);
+    c = inputChars.front();
+    inputChars.pop();
+    inputReady = !inputChars.empty();
+  }
+  writeWord(termIn, (unsigned char)c);
+  pendingInterrupts |= 1 << terminalCause;
+}
+
+// Same as INT, but with the device's cause and all interrupts masked until the handler's iret:
+void acceptInterrupt() {
+  if (!pendingInterrupts || (csr[status] & 0x4)) return;
+
+  uint c;
+  if ((pendingInterrupts & (1 << timerCause)) && !(csr[status] & 0x1)) c = timerCause;
+  else if ((pendingInterrupts & (1 << terminalCause)) && !(csr[status] & 0x2)) c = terminalCause;
+  else return;
+  pendingInterrupts &= ~(1 << c);
+
+  pushCSR(status);
+  pushGPR(pc);
+  csr[cause] = c;
+  csr[status] = csr[status] | 0x4;
+  gpr[pc] = csr[handler];
+}
+
+void handleEvents() {
+  while (!events.empty() && events.top().when <= instrCount) {
+    DeviceEvent e = events.top();
+    events.pop();
+
+    if (e.kind == TIMER_EVENT) {
+      if (e.generation != timerGeneration) continue;  // Period was changed since.
+      if (csr[handler]) pendingInterrupts |= 1 << timerCause;  // Ticks before the handler is set are lost.
+      uint cfg = readWord(timCfg) & 0x7;
+      events.push({ e.when + timerPeriodsMs[cfg] * virtualInstrsPerMs, TIMER_EVENT, timerGeneration });
+    }
+    else {
+      pollTerminalInput();
+      events.push({ e.when + inputPollInstrs, INPUT_POLL_EVENT, 0 });
+    }
+  }
+
+  acceptInterrupt();
+  eventDeadline = events.empty() ? (ulong)-1 : events.top().when;
+}
+
+
+void deviceWrite(uint address, uint value) {
+  if (address == termOut) {
+    putchar(value & 0xff);
+    fflush(stdout);
+  }
+  else if (address == timCfg) scheduleTimer();
+}
+
+void deviceStatusWritten() {
+  if (pendingInterrupts) eventDeadline = 0;
+}
@@ -1,67 +1,209 @@
 #include "../inc/emulator.hpp"
+#include "../inc/jit.hpp"
+#include "../inc/devices.hpp"
 
 
-enum GPR {
-  r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, sp, pc
-};
-enum CSR {
-  status, handler, cause
-};
-
 int gpr[16];  // Important to cast to (uint) if used as an address (when you are adding it to memory).
 uint csr[3];
 
 char* memory; // Starting address of host's 2^32 bytes of memory that will emulate the guest's memory.
+bool sparseMemory = false;  // Option '-sparse': guest memory is kept in 4KiB pages allocated on the first write instead.
+SparseTable* sparseTables[sparseLevelSize];
+char sparseZeroPage[1 << pageBits];  // Read in place of pages that were never written to.
+ulong sparsePageCount = 0;
+char* sparseLastPage = nullptr;  // Last allocated page that was accessed, and its number.
+uint sparseLastPageNum;
+
+string inputFileName;
+Engine engine = REFERENCE;  // Options '-threaded' and '-jit' replace the reference emulate() loop.
+bool printStats = false;        // Option '-stats': report the number of executed instructions and the emulation speed.
+
+ulong instrCount = 0;  // Number of executed instructions.
 
 
 
+int imageTruncated() {
+  fprintf(stderr, "Emulator error: %s is truncated.\n", inputFileName.c_str());
+  return -1;
+}
+
 // Write the linker's memory contents into the memory space used for emulation:
-void initializeMemory(ifstream& in, char* memory) {
+//  (image is the whole mmapped output file of the linker: header, [uint count] and count times [uint startAddress][uint size][size bytes])
+int initializeMemory(int fd, const char* image, ulong imageSize) {
+  if (bCheckHeader(image, imageSize, executableFileMagic, inputFileName) == -1) return -1;
+  ulong offset = binaryFileHeaderSize;
   uint len;
-  in.read((char*)&len, sizeof(uint));
-  //cout << "Len: " << len << endl;
+  if (imageSize - offset < sizeof(uint)) return imageTruncated();
+  memcpy(&len, image + offset, sizeof(uint));
+  offset += sizeof(uint);
 
-  MemoryContent mc;
   for (uint i = 0; i < len; i++) {
-    mc.bRead(in);
-    //cout << "StartAddress: " << mc.startAddress << "  contentSize: " << mc.content.size() << endl; 
+    uint startAddress, contentSize;
+    if (imageSize - offset < 2 * sizeof(uint)) return imageTruncated();
+    memcpy(&startAddress, image + offset, sizeof(uint));
+    memcpy(&contentSize, image + offset + sizeof(uint), sizeof(uint));
+    offset += 2 * sizeof(uint);
+    if (imageSize - offset < contentSize) return imageTruncated();
+
+    // Whole pages can be mapped straight from the file (copy-on-write) when both the guest address and the file offset are page aligned:
+    uint mapped = 0;
+    ulong hostPage = sysconf(_SC_PAGESIZE);
+    if (!sparseMemory && startAddress % hostPage == 0 && offset % hostPage == 0 && contentSize >= hostPage
+    && (ulong)startAddress + contentSize <= (ulong)1 << 32) {
+      mapped = contentSize - contentSize % hostPage;
+      void* res = mmap(memory + startAddress, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, offset);
+      if (res == MAP_FAILED) mapped = 0;
+    }
+
+    copyToGuest(startAddress + mapped, image + offset + mapped, contentSize - mapped);
+    offset += contentSize;
+  }
+
+  return 0;
+}
 
-    for (uint j = 0; j < mc.getContent().size(); j++) {
-      char* adr = (memory + mc.getStartAddress() + j);
-      *adr = mc.getContent()[j];
+// Remember inputFileName and the given options:
+int processCommandLineArguments(int argc, char* argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-threaded") == 0) engine = THREADED;
+    else if (strcmp(argv[i], "-jit") == 0) engine = JIT;
+    else if (strcmp(argv[i], "-stats") == 0) printStats = true;
+    else if (strcmp(argv[i], "-sparse") == 0) sparseMemory = true;
+    else if (argv[i][0] != '-' && inputFileName == "") inputFileName = argv[i];
+    else {
+      inputFileName = "";
+      break;
     }
   }
+
+  if (inputFileName == "") {
+    fprintf(stderr, "Emulator error: invalid command arguments given.\n   Expected './emulator [-threaded | -jit] [-sparse] [-stats] filename'");
+    return -1;
+  }
+
+  return 0;
 }
 
 // Allocate memory for emulation and initialize it:
-int prepareMemory(int argc, char* argv[]) {
+int prepareMemory() {
   /// Reserve space on disk with mmap that will represent the emulated 2^32 bytes of memory on the host machine:
-  int prot = PROT_READ | PROT_WRITE;  // Enables reading and writing.
-  int flags = MAP_PRIVATE | MAP_ANON; // Other processes won't see updates to the mapping. 
-                                      //  Mapping isn't backed by any file. The content is initialized to 0.
-                                      // MAP_ANON => fileDescriptor = -1, offset = 0. 
-  memory = (char*)mmap(nullptr, (ulong)1 << 32, prot, flags, -1, 0);
+  if (!sparseMemory) {
+    int prot = PROT_READ | PROT_WRITE;  // Enables reading and writing.
+    int flags = MAP_PRIVATE | MAP_ANON; // Other processes won't see updates to the mapping. 
+                                        //  Mapping isn't backed by any file. The content is initialized to 0.
+                                        // MAP_ANON => fileDescriptor = -1, offset = 0. 
+    memory = (char*)mmap(nullptr, (ulong)1 << 32, prot, flags, -1, 0);
+  }
 
 
-  /// Open binary input file from linker:
-  if (argc != 2)  {
-    fprintf(stderr, "Emulator error: invalid command arguments given.\n   Expected './emulator filename'");
-    return -1;
-  }
+  /// Open binary input file from linker and map it into the host's memory:
   string prefix = "../tests/";
-  string inputFileName = argv[1];    
   string fileName = prefix + inputFileName;   
-  ifstream in(fileName); 
-  if (in.fail()) {
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) {
     fprintf(stderr, "Emulator error: couldn't open a file with the given filename in the 'tests' directory.\n");
     return -1;
   }
+  struct stat st;
+  char* image = nullptr;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    image = (char*)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (image == MAP_FAILED) image = nullptr;
+  }
+
+  if (!image) {
+    close(fd);
+    fprintf(stderr, "Emulator error: the given file isn't a valid output file of the linker.\n");
+    return -1;
+  }
 
-  /// Read linker's MemoryContents and write them in the host's memory:
-  initializeMemory(in, memory);
-  in.close();
+  /// Write linker's MemoryContents in the host's memory:
+  int res = initializeMemory(fd, image, st.st_size);
+  munmap(image, st.st_size);
+  close(fd);
 
-  return 0;
+  return res;
+}
+
+// Release the emulation memory:
+void freeMemory() {
+  if (!sparseMemory) {
+    munmap(memory, (ulong)1 << 32);
+    return;
+  }
+  for (uint i = 0; i < sparseLevelSize; i++) {
+    if (!sparseTables[i]) continue;
+    for (uint j = 0; j < sparseLevelSize; j++) delete[] sparseTables[i]->pages[j];
+    delete sparseTables[i];
+    sparseTables[i] = nullptr;
+  }
+  sparseLastPage = nullptr;
+}
+
+
+// Sparse memory: (page of the given address, for reading the shared zero page is returned if it wasn't allocated yet)
+char* sparsePage(uint address, bool allocate) {
+  if (sparseLastPage && (address >> pageBits) == sparseLastPageNum) return sparseLastPage;
+
+  SparseTable*& table = sparseTables[address >> (32 - sparseLevelBits)];
+  if (!table) {
+    if (!allocate) return sparseZeroPage;
+    table = new SparseTable();
+  }
+
+  char*& page = table->pages[(address >> pageBits) & (sparseLevelSize - 1)];
+  if (!page) {
+    if (!allocate) return sparseZeroPage;
+    page = new char[1 << pageBits]();
+    sparsePageCount++;
+  }
+  sparseLastPage = page;
+  sparseLastPageNum = address >> pageBits;
+  return page;
+}
+
+// Host address of a guest byte that is about to be written:
+char* guestByte(uint address) {
+  if (!sparseMemory) return memory + address;
+  return sparsePage(address, true) + (address & pageMask);
+}
+
+// Copy a block of bytes into guest memory: (a page at a time for sparse memory, wraps around at the end of the address space)
+void copyToGuest(uint address, const char* src, uint size) {
+  while (size > 0) {
+    uint chunk = size;
+    if (sparseMemory) chunk = min(chunk, (1 << pageBits) - (address & pageMask));
+    else if ((ulong)address + chunk > (ulong)1 << 32) chunk = (uint)(((ulong)1 << 32) - address);
+
+    memcpy(guestByte(address), src, chunk);
+    address += chunk;
+    src += chunk;
+    size -= chunk;
+  }
+}
+
+
+// Guest memory access: (every write goes through here so that the decoded and translated copies of overwritten instructions are dropped)
+uint readWord(uint address) {
+  if (!sparseMemory) return *(uint*)(memory + address);
+
+  if ((address & pageMask) <= pageMask - 3) return *(uint*)(sparsePage(address, false) + (address & pageMask));
+  // Word continues on the next page:
+  uint value = 0;
+  for (uint i = 0; i < 4; i++) {
+    value |= (uint)(unsigned char)sparsePage(address + i, false)[(address + i) & pageMask] << (8 * i);
+  }
+  return value;
+}
+void writeWord(uint address, uint value) {
+  if (!sparseMemory) *(uint*)(memory + address) = value;
+  else if ((address & pageMask) <= pageMask - 3) *(uint*)(sparsePage(address, true) + (address & pageMask)) = value;
+  else {
+    for (uint i = 0; i < 4; i++) *guestByte(address + i) = (char)(value >> (8 * i));
+  }
+  invalidateDecoded(address);
+  jitNoteWrite(address);
+  if (address >= devicesStart) deviceWrite(address, value);
 }
 
 
@@ -69,302 +211,329 @@ int prepareMemory(int argc, char* argv[]) {
   // Used by INT.
 void pushCSR(int id) {
   gpr[sp] -= 4;
-  //cout << "   gpr[sp]: " << gpr[sp] << endl;
-  *(uint*)(memory + (uint)gpr[sp]) = csr[id];
-  //cout << "   mem[" << (uint)gpr[sp] << "]: " << *(uint*)(memory + (uint)gpr[sp]) << endl;
+  writeWord((uint)gpr[sp], csr[id]);
 }
   // Used by INT, CALL, PUSH.
 void pushGPR(int id) {
   gpr[sp] -= 4;
-  //cout << "   gpr[sp]: " << gpr[sp] << endl;
-  *(uint*)(memory + (uint)gpr[sp]) = gpr[id];
-  //cout << "   mem[" << (uint)gpr[sp] << "]: " << *(uint*)(memory + (uint)gpr[sp]) << endl;
+  writeWord((uint)gpr[sp], gpr[id]);
 }
 void popCSR(int id) {
-  csr[id] = *(uint*)(memory + (uint)gpr[sp]);
-  //cout << "   csr[" << id << "]:" << csr[id] << endl;
+  csr[id] = readWord((uint)gpr[sp]);
   gpr[sp] += 4;
-  //cout << "   gpr[sp]: " << gpr[sp] << endl;
 }
   // Used by RET, POP.
 void popGPR(int id) {
-  gpr[id] = *(uint*)(memory + (uint)gpr[sp]);
-  //cout << "   gpr[" << id << "]:" << gpr[id] << endl;
+  gpr[id] = readWord((uint)gpr[sp]);
   gpr[sp] += 4;
-  //cout << "   gpr[sp]: " << gpr[sp] << endl;
 }
 
 
-// Execute emulation of machine instructions starting from the pc address:
-int emulate() {
-  uint curWord;
-  uint opCode, mode, regA, regB, regC, disp;
+// Instruction handlers: (pc already points to the next instruction when a handler is called)
+int execHalt(DecodedInstr& di) {
+  return 1;
+}
+int execInt(DecodedInstr& di) {
+  pushCSR(status);
+  pushGPR(pc);
+  csr[cause] = 4;
+  csr[status] = csr[status] & (~0x1);
+  gpr[pc] = csr[handler];
+  deviceStatusWritten();
+  return 0;
+}
+int execUnrecognized(DecodedInstr& di) {
+  fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
+  return -1;
+}
 
-  //cout << endl << endl << endl;
+  // CALL:
+int execCall(DecodedInstr& di) {
+  pushGPR(pc);
+  gpr[pc] = gpr[di.regA] + gpr[di.regB] + di.disp;
+  return 0;
+}
+int execCallMem(DecodedInstr& di) {
+  pushGPR(pc);
+  gpr[pc] = readWord((uint)gpr[di.regA] + (uint)gpr[di.regB] + di.disp);
+  return 0;
+}
+int execCallNoJump(DecodedInstr& di) {  // Unused CALL modes only push the return address.
+  pushGPR(pc);
+  return 0;
+}
 
-  while(true) {
-    // Read 4 bytes from memory in the little endian format:
-    //cout << uppercase << hex << "PC: " << (uint)gpr[pc] << "  INSTRUCTION: "; 
-    curWord = *(uint*)(memory + (uint)gpr[pc]);  
-    gpr[pc] += 4;
+  // JMP, BRANCH:
+int execJmp(DecodedInstr& di) {
+  gpr[pc] = gpr[di.regA] + di.disp;
+  return 0;
+}
+int execBeq(DecodedInstr& di) {
+  if (gpr[di.regB] == gpr[di.regC]) gpr[pc] = gpr[di.regA] + di.disp;
+  return 0;
+}
+int execBne(DecodedInstr& di) {
+  if (gpr[di.regB] != gpr[di.regC]) gpr[pc] = gpr[di.regA] + di.disp;
+  return 0;
+}
+int execBgt(DecodedInstr& di) {
+  if (gpr[di.regB] > gpr[di.regC]) gpr[pc] = gpr[di.regA] + di.disp;
+  return 0;
+}
+int execJmpMem(DecodedInstr& di) {
+  gpr[pc] = readWord((uint)gpr[di.regA] + di.disp);
+  return 0;
+}
+int execBeqMem(DecodedInstr& di) {
+  if (gpr[di.regB] == gpr[di.regC]) gpr[pc] = readWord((uint)gpr[di.regA] + di.disp);
+  return 0;
+}
+int execBneMem(DecodedInstr& di) {
+  if (gpr[di.regB] != gpr[di.regC]) gpr[pc] = readWord((uint)gpr[di.regA] + di.disp);
+  return 0;
+}
+int execBgtMem(DecodedInstr& di) {
+  if (gpr[di.regB] > gpr[di.regC]) gpr[pc] = readWord((uint)gpr[di.regA] + di.disp);
+  return 0;
+}
+
+  // XCHG:
+int execXchg(DecodedInstr& di) {
+  long tmp = gpr[di.regB];
+  gpr[di.regB] = gpr[di.regC];
+  gpr[di.regC] = tmp;
+  return 0;
+}
 
-    // Filter out opCode, mode, regs and disp from the 4 bytes:
-    opCode = (curWord >> 28);
-    mode = (curWord >> 24) & 0xf;
-    regA = (curWord >> 20) & 0xf;
-    regB = (curWord >> 16) & 0xf;
-    regC = (curWord >> 12) & 0xf;
-    disp = curWord & 0xfff;
+  // ADD, SUB, MUL, DIV:
+int execAdd(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] + gpr[di.regC]; return 0; }
+int execSub(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] - gpr[di.regC]; return 0; }
+int execMul(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] * gpr[di.regC]; return 0; }
+int execDiv(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] / gpr[di.regC]; return 0; }
+
+  // NOT, AND, OR, XOR:
+int execNot(DecodedInstr& di) { gpr[di.regA] = ~gpr[di.regB]; return 0; }
+int execAnd(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] & gpr[di.regC]; return 0; }
+int execOr(DecodedInstr& di)  { gpr[di.regA] = gpr[di.regB] | gpr[di.regC]; return 0; }
+int execXor(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] ^ gpr[di.regC]; return 0; }
+
+  // SHL, SHR:
+int execShl(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] << gpr[di.regC]; return 0; }
+int execShr(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] >> gpr[di.regC]; return 0; }
+
+  // PUSH, ST:
+int execSt(DecodedInstr& di) {
+  writeWord((uint)gpr[di.regA] + (uint)gpr[di.regB] + di.disp, gpr[di.regC]);
+  return 0;
+}
+int execPush(DecodedInstr& di) {
+  pushGPR(di.regC);
+  return 0;
+}
+int execStMem(DecodedInstr& di) {
+  writeWord(readWord((uint)gpr[di.regA] + (uint)gpr[di.regB] + di.disp), gpr[di.regC]);
+  return 0;
+}
 
+  // LD, CSRWR, CSRRD, POP, IRET(first csrrd then pop), RET(pop):
+int execCsrrd(DecodedInstr& di) { gpr[di.regA] = csr[di.regB]; return 0; }
+int execLdReg(DecodedInstr& di) { gpr[di.regA] = gpr[di.regB] + di.disp; return 0; }
+int execLdMem(DecodedInstr& di) {
+  gpr[di.regA] = readWord((uint)gpr[di.regB] + (uint)gpr[di.regC] + di.disp);
+  return 0;
+}
+int execPop(DecodedInstr& di) {  // Can't use popGPR because IRET uses disp 8, not 4.
+  gpr[di.regA] = readWord((uint)gpr[di.regB]);
+  gpr[di.regB] = gpr[di.regB] + di.disp;
+  return 0;
+}
+int execCsrwr(DecodedInstr& di) {
+  csr[di.regA] = gpr[di.regB];
+  if (di.regA == status) deviceStatusWritten();
+  return 0;
+}
+int execCsrOr(DecodedInstr& di) {
+  csr[di.regA] = csr[di.regB] | di.disp;
+  if (di.regA == status) deviceStatusWritten();
+  return 0;
+}
+int execCsrLd(DecodedInstr& di) {
+  csr[di.regA] = readWord((uint)gpr[di.regB] + (uint)gpr[di.regC] + di.disp);
+  if (di.regA == status) deviceStatusWritten();
+  return 0;
+}
+int execPopCsr(DecodedInstr& di) {
+  csr[di.regA] = readWord((uint)gpr[di.regB]);
+  gpr[di.regB] = gpr[di.regB] + di.disp;
+  if (di.regA == status) deviceStatusWritten();
+  return 0;
+}
+int execNop(DecodedInstr& di) {  // Unused SHL/SHR and PUSH/ST modes don't do anything.
+  return 0;
+}
 
-    // Recognize the current machine instruction and execute it:
-    // HALT:
-    if (curWord == 0) {
-      //cout << "HALT" << endl;
-      break;
-    }
-    // INT:
-    else if (curWord == 0x10000000) {
-      //cout << "INT" << endl;
-      pushCSR(status);
-      pushGPR(pc);
-      csr[cause] = 4;
-      //cout << "   cause: " << csr[cause] << endl;
-      csr[status] = csr[status] & (~0x1);
-      //cout << "   status: " << csr[status] << endl;
-      gpr[pc] = csr[handler];
-      //cout << "   pc: " << gpr[pc] << endl;
-    }
-    // CALL:
-    else if (opCode == 0x2) {
-      //cout << "CALL" << endl;
-      pushGPR(pc);
-      if (mode == 0) {
-        gpr[pc] = gpr[regA] + gpr[regB] + disp;
-        //cout << "   pc:" << gpr[pc] << endl;
-      }
-      else if (mode == 1) {
-        gpr[pc] = *(uint*)(memory + (uint)gpr[regA] + (uint)gpr[regB] + disp);
-        //cout << "   pc:" << gpr[pc] << endl;
-      }
-    }
-    // JMP, BRANCH:
-    else if (opCode == 0x3) {
-      switch (mode) {
-        case 0:
-          //cout << "JMP" << endl;
-          gpr[pc] = gpr[regA] + disp;
-          //cout << "   pc: " << gpr[pc] << endl;
-          break;
-        case 1:
-          //cout << "BEQ" << endl;
-          if (gpr[regB] == gpr[regC]) {
-            gpr[pc] = gpr[regA] + disp;
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        case 2:
-          //cout << "BNE" << endl;
-          if (gpr[regB] != gpr[regC]) {
-            gpr[pc] = gpr[regA] + disp;
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        case 3:
-          //cout << "BGT" << endl;
-          if (gpr[regB] > gpr[regC]) {
-            gpr[pc] = gpr[regA] + disp;
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        case 8:
-          //cout << "JMP" << endl;
-          gpr[pc] = *(uint*)(memory + (uint)gpr[regA] + disp);
-          //cout << "   pc: " << gpr[pc] << endl;
-          break;
-        case 9:
-          //cout << "BEQ" << endl;
-          if (gpr[regB] == gpr[regC]) {
-            gpr[pc] = *(uint*)(memory + (uint)gpr[regA] + disp);
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        case 0xA:
-          //cout << "BNE" << endl;
-          if (gpr[regB] != gpr[regC]) {
-            gpr[pc] = *(uint*)(memory + (uint)gpr[regA] + disp);
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        case 0xB:
-          //cout << "BGT" << endl;
-          if (gpr[regB] > gpr[regC]) {
-            gpr[pc] = *(uint*)(memory + (uint)gpr[regA] + disp);
-            //cout << "   pc: " << gpr[pc] << endl;
-          }
-          break;
-        default:
-          fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
-          return -1;
-      }
-    }
-    // XCHG:
-    else if (opCode == 0x4) {
-      //cout << "XCHG" << endl;
-      long tmp = gpr[regB];
-      gpr[regB] = gpr[regC];
-      //cout << "   gpr[" << regB << "]:" << gpr[regB] << endl;
-      gpr[regC] = tmp;
-      //cout << "   gpr[" << regC << "]:" << gpr[regC] << endl;
+
+// Recognize the machine instruction in the given word and split out its operands:
+void decodeInstr(uint word, DecodedInstr& di) {
+  uint opCode = (word >> 28);
+  uint mode = (word >> 24) & 0xf;
+  di.regA = (word >> 20) & 0xf;
+  di.regB = (word >> 16) & 0xf;
+  di.regC = (word >> 12) & 0xf;
+  di.disp = word & 0xfff;
+
+  // HALT, INT:
+  if (word == 0) di.handler = execHalt;
+  else if (word == 0x10000000) di.handler = execInt;
+  // CALL:
+  else if (opCode == 0x2) {
+    if (mode == 0) di.handler = execCall;
+    else if (mode == 1) di.handler = execCallMem;
+    else di.handler = execCallNoJump;
+  }
+  // JMP, BRANCH:
+  else if (opCode == 0x3) {
+    switch (mode) {
+      case 0:   di.handler = execJmp; break;
+      case 1:   di.handler = execBeq; break;
+      case 2:   di.handler = execBne; break;
+      case 3:   di.handler = execBgt; break;
+      case 8:   di.handler = execJmpMem; break;
+      case 9:   di.handler = execBeqMem; break;
+      case 0xA: di.handler = execBneMem; break;
+      case 0xB: di.handler = execBgtMem; break;
+      default:  di.handler = execUnrecognized; break;
     }
-    // ADD, SUB, MUL, DIV:
-    else if (opCode == 0x5) {
-      switch (mode) {
-        case 0:
-          //cout << "ADD" << endl;
-          gpr[regA] = gpr[regB] + gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 1:
-          //cout << "SUB" << endl;
-          gpr[regA] = gpr[regB] - gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 2:
-          //cout << "MUL" << endl;
-          gpr[regA] = gpr[regB] * gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 3:
-          //cout << "DIV" << endl;
-          gpr[regA] = gpr[regB] / gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        default:
-          fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
-          return -1;
-      }
+  }
+  // XCHG:
+  else if (opCode == 0x4) di.handler = execXchg;
+  // ADD, SUB, MUL, DIV:
+  else if (opCode == 0x5) {
+    switch (mode) {
+      case 0:  di.handler = execAdd; break;
+      case 1:  di.handler = execSub; break;
+      case 2:  di.handler = execMul; break;
+      case 3:  di.handler = execDiv; break;
+      default: di.handler = execUnrecognized; break;
     }
-    // NOT, AND, OR, XOR:
-    else if (opCode == 0x6) {
-      switch (mode) {
-        case 0:
-          //cout << "NOT" << endl;
-          gpr[regA] = ~gpr[regB];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 1:
-          //cout << "AND" << endl;
-          gpr[regA] = gpr[regB] & gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 2:
-          //cout << "OR" << endl;
-          gpr[regA] = gpr[regB] | gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 3:
-          //cout << "XOR" << endl;
-          gpr[regA] = gpr[regB] ^ gpr[regC];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        default:
-          fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
-          return -1;
-      }
+  }
+  // NOT, AND, OR, XOR:
+  else if (opCode == 0x6) {
+    switch (mode) {
+      case 0:  di.handler = execNot; break;
+      case 1:  di.handler = execAnd; break;
+      case 2:  di.handler = execOr; break;
+      case 3:  di.handler = execXor; break;
+      default: di.handler = execUnrecognized; break;
     }
-    // SHL, SHR:
-    else if (opCode == 0x7) {
-      if (mode == 0) {
-        //cout << "SHL" << endl;
-        gpr[regA] = gpr[regB] << gpr[regC];
-        //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-      }
-      else if (mode == 1) {
-        //cout << "SHR" << endl;
-        gpr[regA] = gpr[regB] >> gpr[regC];
-        //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-      }
+  }
+  // SHL, SHR:
+  else if (opCode == 0x7) {
+    if (mode == 0) di.handler = execShl;
+    else if (mode == 1) di.handler = execShr;
+    else di.handler = execNop;
+  }
+  // PUSH, ST:
+  else if (opCode == 0x8) {
+    if (mode == 0) di.handler = execSt;
+    else if (mode == 1) di.handler = execPush;
+    else if (mode == 2) di.handler = execStMem;
+    else di.handler = execNop;
+  }
+  // LD, CSRWR, CSRRD, POP, IRET(first csrrd then pop), RET(pop):
+  else if (opCode == 0x9) {
+    switch (mode) {
+      case 0:  di.handler = execCsrrd; break;
+      case 1:  di.handler = execLdReg; break;
+      case 2:  di.handler = execLdMem; break;
+      case 3:  di.handler = execPop; break;
+      case 4:  di.handler = execCsrwr; break;
+      case 5:  di.handler = execCsrOr; break;
+      case 6:  di.handler = execCsrLd; break;
+      case 7:  di.handler = execPopCsr; break;
+      default: di.handler = execUnrecognized; break;
     }
-    // PUSH, ST: 
-    else if (opCode == 0x8) {
-      if (mode == 0) {
-        //cout << "ST" << endl;
-        *(uint*)(memory + (uint)gpr[regA] + (uint)gpr[regB] + disp) = gpr[regC];
-        //cout << "   mem[" << (uint)gpr[regA] + (uint)gpr[regB] + disp << "]: " <<  *(uint*)(memory + (uint)gpr[regA] + (uint)gpr[regB] + disp) << endl;
-      }
-      else if (mode == 1) {
-        //cout << "PUSH" << endl;
-        pushGPR(regC);
-      }
-      else if (mode == 2) {
-        //cout << "ST" << endl;
-        uint tmp = *(uint*)(memory + (uint)gpr[regA] + (uint)gpr[regB] + disp);
-        *(uint*)(memory + tmp) = gpr[regC];
-        //cout << "   mem[" << tmp << "]: " <<  *(uint*)(memory + tmp) << endl;
-      }
+  }
+  // UNRECOGNIZED:
+  else di.handler = execUnrecognized;
+}
+
+// Placeholder handler of every slot that wasn't decoded yet (or was overwritten since): 
+//  decodes the word the slot stands for, remembers the result and executes it.
+int execDecode(DecodedInstr& di) {
+  uint address = (uint)gpr[pc] - 4;
+  decodeInstr(readWord(address), di);
+  return di.handler(di);
+}
+
+
+// Decoded instruction cache: (one lazily allocated DecodedPage per 4KiB page of guest memory that instructions were fetched from)
+DecodedPage* decodedPages[decodedPageCount];
+
+// Returns the decoded page that contains the given address:
+DecodedPage& fetchDecodedPage(uint address) {
+  DecodedPage* page = decodedPages[address >> pageBits];
+  if (!page) {
+    page = new DecodedPage();
+    for (uint i = 0; i < instrsPerPage; i++) page->instrs[i].handler = execDecode;
+    decodedPages[address >> pageBits] = page;
+  }
+  return *page;
+}
+
+// Drops decoded instructions that overlap the 4 bytes written at the given address:
+void invalidateDecoded(uint address) {
+  DecodedPage* page = decodedPages[address >> pageBits];
+  if (page) page->instrs[(address & pageMask) >> 2].handler = execDecode;
+
+  // An unaligned write also reaches into the next slot (which can be on the next page):
+  if (address & 0x3) {
+    address += 4;
+    page = decodedPages[address >> pageBits];
+    if (page) page->instrs[(address & pageMask) >> 2].handler = execDecode;
+  }
+}
+
+void freeDecodeCache() {
+  for (uint i = 0; i < decodedPageCount; i++) {
+    delete decodedPages[i];
+    decodedPages[i] = nullptr;
+  }
+}
+
+
+// Execute emulation of machine instructions starting from the pc address:
+int emulate() {
+  DecodedInstr unaligned;
+  DecodedPage* page = nullptr;  // Decoded page that the pc was in during the previous step.
+  uint pageNum = 0;
+
+  while(true) {
+    // Device events are due: (can enter an interrupt handler)
+    if (instrCount >= eventDeadline) handleEvents();
+
+    uint address = (uint)gpr[pc];
+    gpr[pc] += 4;
+
+    DecodedInstr* di;
+    // Only 4B aligned instructions are cached, others are decoded on every execution:
+    if (address & 0x3) {
+      decodeInstr(readWord(address), unaligned);
+      di = &unaligned;
     }
-    // LD, CSRWR, CSRRD, POP, IRET(first csrrd then pop), RET(pop):
-    else if (opCode == 0x9) {
-      switch (mode) {
-        case 0:
-          //cout << "CSRRD" << endl;
-          gpr[regA] = csr[regB];
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 1:
-          //cout << "LD" << endl;
-          gpr[regA] = gpr[regB] + disp;
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 2:
-          //cout << "LD" << endl;
-          gpr[regA] = *(uint*)(memory + (uint)gpr[regB] + (uint)gpr[regC] + disp);
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          break;
-        case 3:
-          //cout << "POP" << endl;
-          //popGPR(regA); (can't use this because IRET uses disp 8, not 4)
-
-          //In case this mode is later needed for something other than just POP, this code will do both:
-          gpr[regA] = *(uint*)(memory + (uint)gpr[regB]);
-          //cout << "   gpr[" << regA << "]:" << gpr[regA] << endl;
-          gpr[regB] = gpr[regB] + disp;
-          //cout << "   gpr[" << regB << "]:" << gpr[regB] << endl;
-          break;
-        case 4:
-          //cout << "CSRWR" << endl;
-          csr[regA] = gpr[regB];
-          //cout << "   csr[" << regA << "]:" << csr[regA] << endl;
-          break;
-        case 5:
-          csr[regA] = csr[regB] | disp;
-          //cout << "   csr[" << regA << "]:" << csr[regA] << endl;
-          break;
-        case 6:
-          //cout << "LD" << endl;
-          csr[regA] = *(uint*)(memory + (uint)gpr[regB] + (uint)gpr[regC] + disp);
-          //cout << "   csr[" << regA << "]:" << csr[regA] << endl;
-          break;
-        case 7:
-          //cout << "POP" << endl;
-          //popCSR(regA);
-
-          // In case this mode is later needed for something other than just POP, this code will do both:
-          csr[regA] = *(uint*)(memory + (uint)gpr[regB]);
-          //cout << "   csr[" << regA << "]:" << csr[regA] << endl;
-          gpr[regB] = gpr[regB] + disp;
-          //cout << "   gpr[" << regB << "]:" << gpr[regB] << endl;
-          break;
-        default:
-          fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
-          return -1;
+    else {
+      if (!page || (address >> pageBits) != pageNum) {
+        pageNum = address >> pageBits;
+        page = &fetchDecodedPage(address);
       }
+      di = &page->instrs[(address & pageMask) >> 2];
     }
-    // UNRECOGNIZED:
-    else {
-      fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
-      return -1;
+
+    instrCount++;
+    int res = di->handler(*di);
+    if (res != 0) {
+      if (res == 1) break;  // HALT.
+      return -1;            // Unrecognized instruction.
     }
   
     // Always keep r0 at zero:
@@ -375,6 +544,216 @@ int emulate() {
 }
 
 
+// Execute emulation with direct-threaded dispatch: (every instruction jumps straight to the code of the next one
+//  through a table of label addresses indexed by the instruction's opCode|mode byte)
+int emulateThreaded() {
+  static void* dispatchTable[256];
+  uint word, regA, regB, regC, disp;
+
+  for (int i = 0; i < 256; i++) dispatchTable[i] = &&UNRECOGNIZED;
+  dispatchTable[0x00] = &&HALT;
+  dispatchTable[0x10] = &&INT;
+  for (int i = 0x20; i <= 0x2F; i++) dispatchTable[i] = &&CALL_NO_JUMP;
+  dispatchTable[0x20] = &&CALL;
+  dispatchTable[0x21] = &&CALL_MEM;
+  dispatchTable[0x30] = &&JMP;
+  dispatchTable[0x31] = &&BEQ;
+  dispatchTable[0x32] = &&BNE;
+  dispatchTable[0x33] = &&BGT;
+  dispatchTable[0x38] = &&JMP_MEM;
+  dispatchTable[0x39] = &&BEQ_MEM;
+  dispatchTable[0x3A] = &&BNE_MEM;
+  dispatchTable[0x3B] = &&BGT_MEM;
+  for (int i = 0x40; i <= 0x4F; i++) dispatchTable[i] = &&XCHG;
+  dispatchTable[0x50] = &&ADD;
+  dispatchTable[0x51] = &&SUB;
+  dispatchTable[0x52] = &&MUL;
+  dispatchTable[0x53] = &&DIV;
+  dispatchTable[0x60] = &&NOT;
+  dispatchTable[0x61] = &&AND;
+  dispatchTable[0x62] = &&OR;
+  dispatchTable[0x63] = &&XOR;
+  for (int i = 0x70; i <= 0x8F; i++) dispatchTable[i] = &&NOP;
+  dispatchTable[0x70] = &&SHL;
+  dispatchTable[0x71] = &&SHR;
+  dispatchTable[0x80] = &&ST;
+  dispatchTable[0x81] = &&PUSH;
+  dispatchTable[0x82] = &&ST_MEM;
+  dispatchTable[0x90] = &&CSRRD;
+  dispatchTable[0x91] = &&LD_REG;
+  dispatchTable[0x92] = &&LD_MEM;
+  dispatchTable[0x93] = &&POP;
+  dispatchTable[0x94] = &&CSRWR;
+  dispatchTable[0x95] = &&CSR_OR;
+  dispatchTable[0x96] = &&CSR_LD;
+  dispatchTable[0x97] = &&POP_CSR;
+
+// Keep r0 at zero, handle due device events, fetch the next instruction, split out its operands and jump to its code:
+#define DISPATCH() \
+  gpr[r0] = 0; \
+  if (instrCount >= eventDeadline) handleEvents(); \
+  word = readWord((uint)gpr[pc]); \
+  gpr[pc] += 4; \
+  instrCount++; \
+  regA = (word >> 20) & 0xf; \
+  regB = (word >> 16) & 0xf; \
+  regC = (word >> 12) & 0xf; \
+  disp = word & 0xfff; \
+  goto *dispatchTable[word >> 24]
+
+  DISPATCH();
+
+  // HALT, INT: (the whole word has to match)
+HALT:
+  if (word != 0) goto UNRECOGNIZED;
+  return 0;
+INT:
+  if (word != 0x10000000) goto UNRECOGNIZED;
+  pushCSR(status);
+  pushGPR(pc);
+  csr[cause] = 4;
+  csr[status] = csr[status] & (~0x1);
+  gpr[pc] = csr[handler];
+  deviceStatusWritten();
+  DISPATCH();
+
+  // CALL:
+CALL:
+  pushGPR(pc);
+  gpr[pc] = gpr[regA] + gpr[regB] + disp;
+  DISPATCH();
+CALL_MEM:
+  pushGPR(pc);
+  gpr[pc] = readWord((uint)gpr[regA] + (uint)gpr[regB] + disp);
+  DISPATCH();
+CALL_NO_JUMP:
+  pushGPR(pc);
+  DISPATCH();
+
+  // JMP, BRANCH:
+JMP:
+  gpr[pc] = gpr[regA] + disp;
+  DISPATCH();
+BEQ:
+  if (gpr[regB] == gpr[regC]) gpr[pc] = gpr[regA] + disp;
+  DISPATCH();
+BNE:
+  if (gpr[regB] != gpr[regC]) gpr[pc] = gpr[regA] + disp;
+  DISPATCH();
+BGT:
+  if (gpr[regB] > gpr[regC]) gpr[pc] = gpr[regA] + disp;
+  DISPATCH();
+JMP_MEM:
+  gpr[pc] = readWord((uint)gpr[regA] + disp);
+  DISPATCH();
+BEQ_MEM:
+  if (gpr[regB] == gpr[regC]) gpr[pc] = readWord((uint)gpr[regA] + disp);
+  DISPATCH();
+BNE_MEM:
+  if (gpr[regB] != gpr[regC]) gpr[pc] = readWord((uint)gpr[regA] + disp);
+  DISPATCH();
+BGT_MEM:
+  if (gpr[regB] > gpr[regC]) gpr[pc] = readWord((uint)gpr[regA] + disp);
+  DISPATCH();
+
+  // XCHG:
+XCHG: {
+    long tmp = gpr[regB];
+    gpr[regB] = gpr[regC];
+    gpr[regC] = tmp;
+  }
+  DISPATCH();
+
+  // ADD, SUB, MUL, DIV:
+ADD:
+  gpr[regA] = gpr[regB] + gpr[regC];
+  DISPATCH();
+SUB:
+  gpr[regA] = gpr[regB] - gpr[regC];
+  DISPATCH();
+MUL:
+  gpr[regA] = gpr[regB] * gpr[regC];
+  DISPATCH();
+DIV:
+  gpr[regA] = gpr[regB] / gpr[regC];
+  DISPATCH();
+
+  // NOT, AND, OR, XOR:
+NOT:
+  gpr[regA] = ~gpr[regB];
+  DISPATCH();
+AND:
+  gpr[regA] = gpr[regB] & gpr[regC];
+  DISPATCH();
+OR:
+  gpr[regA] = gpr[regB] | gpr[regC];
+  DISPATCH();
+XOR:
+  gpr[regA] = gpr[regB] ^ gpr[regC];
+  DISPATCH();
+
+  // SHL, SHR:
+SHL:
+  gpr[regA] = gpr[regB] << gpr[regC];
+  DISPATCH();
+SHR:
+  gpr[regA] = gpr[regB] >> gpr[regC];
+  DISPATCH();
+
+  // PUSH, ST:
+ST:
+  writeWord((uint)gpr[regA] + (uint)gpr[regB] + disp, gpr[regC]);
+  DISPATCH();
+PUSH:
+  pushGPR(regC);
+  DISPATCH();
+ST_MEM:
+  writeWord(readWord((uint)gpr[regA] + (uint)gpr[regB] + disp), gpr[regC]);
+  DISPATCH();
+NOP:
+  DISPATCH();
+
+  // LD, CSRWR, CSRRD, POP, IRET(first csrrd then pop), RET(pop):
+CSRRD:
+  gpr[regA] = csr[regB];
+  DISPATCH();
+LD_REG:
+  gpr[regA] = gpr[regB] + disp;
+  DISPATCH();
+LD_MEM:
+  gpr[regA] = readWord((uint)gpr[regB] + (uint)gpr[regC] + disp);
+  DISPATCH();
+POP:
+  gpr[regA] = readWord((uint)gpr[regB]);
+  gpr[regB] = gpr[regB] + disp;
+  DISPATCH();
+CSRWR:
+  csr[regA] = gpr[regB];
+  if (regA == status) deviceStatusWritten();
+  DISPATCH();
+CSR_OR:
+  csr[regA] = csr[regB] | disp;
+  if (regA == status) deviceStatusWritten();
+  DISPATCH();
+CSR_LD:
+  csr[regA] = readWord((uint)gpr[regB] + (uint)gpr[regC] + disp);
+  if (regA == status) deviceStatusWritten();
+  DISPATCH();
+POP_CSR:
+  csr[regA] = readWord((uint)gpr[regB]);
+  gpr[regB] = gpr[regB] + disp;
+  if (regA == status) deviceStatusWritten();
+  DISPATCH();
+
+#undef DISPATCH
+
+  // UNRECOGNIZED:
+UNRECOGNIZED:
+  fprintf(stderr, "Emulator Error: Unrecognized machine instruction.\n");
+  return -1;
+}
+
+
 // Helper fun for printing results: (register value is given as a uint, this will use only the lower 32b)
 string intToHex(uint num, int hexLen) {
   ostringstream ss;
@@ -402,28 +781,58 @@ void printResults() {
 
 
 
+// Print the number of executed instructions and the emulation speed: (to stderr, so that the results stay in the specified format)
+void printEmulationStats(double seconds) {
+  fprintf(stderr, "Executed %lu instructions in %.3f s (%.1f MIPS, %s).\n",
+    instrCount, seconds, seconds > 0 ? instrCount / seconds / 1e6 : 0.0,
+    engine == THREADED ? "threaded dispatch" : engine == JIT ? "jit" : "reference dispatch");
+  if (sparseMemory) fprintf(stderr, "Sparse memory: %lu pages (%lu KiB) allocated.\n", sparsePageCount, sparsePageCount << (pageBits - 10));
+}
+
+
+
+
 int main(int argc, char* argv[]) {
+  /// Process command line arguments:
+  if (processCommandLineArguments(argc, argv) == -1) return -1;
 
   // Allocate host's emulation memory and initialize it with linker's MemoryContents:
-  if (prepareMemory(argc, argv) == -1) {
-    munmap(memory, (ulong)1 << 32);
+  if (prepareMemory() == -1) {
+    freeMemory();
     return -1;
   }
 
   /// Initialize registers: (pc = 0x40000000)
   gpr[pc] = 0x40000000;
 
+  /// Start the timer and terminal:
+  devicesInit();
+
   /// Emulate: 
-  if (emulate() == -1) {
-    munmap(memory, (ulong)1 << 32);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  int res;
+  if (engine == THREADED) res = emulateThreaded();
+  else if (engine == JIT) res = emulateJit();
+  else res = emulate();
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  if (res == -1) {
+    devicesFree();
+    freeDecodeCache();
+    jitFree();
+    freeMemory();
     return -1;
   }
 
   /// Showcase results:
   printResults();
+  if (printStats) printEmulationStats(seconds);
 
   /// Free memory:
-  munmap(memory, (ulong)1 << 32);
+  devicesFree();
+  freeDecodeCache();
+  jitFree();
+  freeMemory();
 
   return 0;
 }
\ No newline at end of file
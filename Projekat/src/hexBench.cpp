@@ -0,0 +1,68 @@
+#include <chrono>
+#include <random>
+#include "../inc/hexWriter.hpp"
+
+
+// Compares hexPrint and hexWrite on the same memory contents: (hexbench [megabytes])
+//  Contents start at unaligned addresses, some of them in the line where the previous one ended, some are empty.
+vector<MemoryContent> makeContents(ulong totalSize) {
+  vector<MemoryContent> memoryContents;
+  mt19937 rng(12345);
+  uint address = 0x40000000;
+  ulong size = 0;
+
+  while (size < totalSize) {
+    uint len = rng() % 4 == 0 ? rng() % 16 : rng() % (1 << 16);
+    vector<char> content(len);
+    for (char& c : content) c = rng();
+
+    memoryContents.push_back(MemoryContent(address, std::move(content)));
+    size += len;
+    address += len + (rng() % 2 == 0 ? rng() % 8 : rng() % 4096);
+  }
+  return memoryContents;
+}
+
+// Writes the text with the given function, returns the time it took in ms:
+double timeWriter(void (*writer)(FILE*, const vector<MemoryContent>&), const vector<MemoryContent>& memoryContents, string fileName) {
+  FILE* outputFile = fopen(fileName.c_str(), "w");
+  if (!outputFile) {
+    fprintf(stderr, "Error: Couldn't open %s.\n", fileName.c_str());
+    exit(-1);
+  }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  writer(outputFile, memoryContents);
+  fclose(outputFile);
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Checks that both files have the same text:
+bool sameFiles(string fileName1, string fileName2) {
+  ifstream f1(fileName1, ios::binary), f2(fileName2, ios::binary);
+  istreambuf_iterator<char> end;
+  return vector<char>(istreambuf_iterator<char>(f1), end) == vector<char>(istreambuf_iterator<char>(f2), end);
+}
+
+
+int main(int argc, char* argv[]) {
+  ulong megabytes = argc > 1 ? atoi(argv[1]) : 16;
+  vector<MemoryContent> memoryContents = makeContents(megabytes << 20);
+
+  string prefix = "../tests/";
+  double printTime = timeWriter(hexPrint, memoryContents, prefix + "hexbench.print.txt");
+  double writeTime = timeWriter(hexWrite, memoryContents, prefix + "hexbench.write.txt");
+
+  if (!sameFiles(prefix + "hexbench.print.txt", prefix + "hexbench.write.txt")) {
+    fprintf(stderr, "Error: hexPrint and hexWrite wrote different text.\n");
+    return -1;
+  }
+
+  printf("%lu MB in %zu memory contents:\n", megabytes, memoryContents.size());
+  printf("  hexPrint: %8.1f ms\n", printTime);
+  printf("  hexWrite: %8.1f ms  (%.1fx)\n", writeTime, printTime / writeTime);
+
+  remove((prefix + "hexbench.print.txt").c_str());
+  remove((prefix + "hexbench.write.txt").c_str());
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "../inc/hexWriter.hpp"
+
+
+// Writes memory contents as text, 8 bytes per line after their address, '--' for unused bytes in a line:
+void hexPrint(FILE* outputFile, const vector<MemoryContent>& memoryContents) {
+  uint addressCount = 0;
+  uint stPos = 0;  // Indicates on what byte in line did we stop printing the previous section
+
+  for (vector<MemoryContent>::const_iterator it = memoryContents.begin(); it != memoryContents.end(); it++) {
+    // If the content of the next section should start in the same line where the previous section's ended:
+    if (it->getStartAddress() < addressCount + 8 && stPos != 0) {
+      int byteInLine = it->getStartAddress() % 8;
+      // Print '--' for the unused bytes in the line between the end of the previous and the start of the next section:
+      while (stPos < byteInLine) {
+        fprintf(outputFile, "-- ");
+        stPos++;
+      }
+    }
+    // Otherwise, skip to the 8byte including the starting byte of the next section:
+    else {
+      if (stPos != 0) fprintf(outputFile, "\n");
+      stPos = 0;  // this is necessary!
+
+      int byteInLine = it->getStartAddress() % 8;
+      addressCount += (it->getStartAddress() - byteInLine) - addressCount;
+
+      // If byteInLine == 0, in the for loop below the address and the line will be printed normally.
+      if (byteInLine != 0) {  
+        ostringstream ss;
+        ss << uppercase << setfill('0') << std::setw(4)<< hex << addressCount;
+        string address = ss.str() + ": ";
+        fprintf(outputFile, "%s", address.c_str());
+
+        // Print '--' for the unused bytes at the start of the 8byte address until the beggining of the section:
+        while (stPos < byteInLine) {
+          fprintf(outputFile, "-- ");
+          stPos++;
+        }
+      }
+    }
+
+
+    // Print the content of the section:
+    const char* sectionContent = it->getData();
+
+    for (uint i = 0; i < it->getSize(); i++) {
+      if (stPos == 0) {
+        ostringstream ss;
+        ss << uppercase << setfill('0') << std::setw(4) << hex << addressCount;
+        string address = ss.str() + ": ";
+        fprintf(outputFile, "%s", address.c_str());
+      }
+
+      char byte = sectionContent[i];
+      int hex1 = ((byte >> 4) & 0xf);
+      int hex2 = (byte & 0xf); 
+
+      fprintf(outputFile, "%X%X ", hex1, hex2); // Todo: check.
+      stPos += 1;
+
+      if (stPos % 8 == 0) {
+        stPos = 0;
+        addressCount += 8;
+        fprintf(outputFile, "\n");
+      }
+    }
+  }
+}
+
+
+// Hex digits of every byte value followed by a space:  "00 ", "01 ", ... "FF "
+struct HexByteTable {
+  char digits[256][3];
+
+  HexByteTable() {
+    const char* hexDigits = "0123456789ABCDEF";
+    for (int i = 0; i < 256; i++) {
+      digits[i][0] = hexDigits[i >> 4];
+      digits[i][1] = hexDigits[i & 0xf];
+      digits[i][2] = ' ';
+    }
+  }
+};
+static const HexByteTable hexBytes;
+
+const uint hexBufferSize = 1 << 20;
+const uint hexMaxLine = 8 + 2 + 8 * 3 + 1;  // Address, ": ", 8 bytes, '\n'
+
+
+// Writes a line's address the way hexPrint does: (uppercase, at least 4 digits)
+static char* putAddress(char* p, uint address) {
+  int digits = 4;
+  while (digits < 8 && (address >> (4 * digits)) != 0) digits++;
+
+  for (int i = digits - 1; i >= 0; i--) {
+    *p++ = hexBytes.digits[(address >> (4 * i)) & 0xf][1];
+  }
+  *p++ = ':';
+  *p++ = ' ';
+  return p;
+}
+
+// Writes the same text as hexPrint: (formats whole lines from a table of bytes' hex digits, into a large buffer)
+void hexWrite(FILE* outputFile, const vector<MemoryContent>& memoryContents) {
+  vector<char> buffer(hexBufferSize);
+  char* p = buffer.data();
+  char* flushAt = buffer.data() + hexBufferSize - 4 * hexMaxLine;  // Leaves room for what's written between two checks.
+
+  uint addressCount = 0;
+  uint stPos = 0;  // Indicates on what byte in line did we stop printing the previous section
+
+  for (const MemoryContent& mc : memoryContents) {
+    if (p > flushAt) {
+      fwrite(buffer.data(), 1, p - buffer.data(), outputFile);
+      p = buffer.data();
+    }
+
+    uint byteInLine = mc.getStartAddress() % 8;
+
+    // If the content of the next section should start in the same line where the previous section's ended:
+    if (mc.getStartAddress() < addressCount + 8 && stPos != 0) {
+      for (; stPos < byteInLine; stPos++, p += 3) memcpy(p, "-- ", 3);
+    }
+    // Otherwise, skip to the 8byte including the starting byte of the next section:
+    else {
+      if (stPos != 0) *p++ = '\n';
+      stPos = 0;
+      addressCount = mc.getStartAddress() - byteInLine;
+
+      if (byteInLine != 0) {
+        p = putAddress(p, addressCount);
+        for (; stPos < byteInLine; stPos++, p += 3) memcpy(p, "-- ", 3);
+      }
+    }
+
+    const unsigned char* bytes = (const unsigned char*)mc.getData();
+    const unsigned char* end = bytes + mc.getSize();
+
+    // Finish the line that is already started:
+    for (; stPos != 0 && bytes != end; bytes++) {
+      memcpy(p, hexBytes.digits[*bytes], 3);
+      p += 3;
+      if (++stPos == 8) {
+        *p++ = '\n';
+        stPos = 0;
+        addressCount += 8;
+      }
+    }
+
+    // Whole lines:
+    for (; end - bytes >= 8; bytes += 8, addressCount += 8) {
+      if (p > flushAt) {
+        fwrite(buffer.data(), 1, p - buffer.data(), outputFile);
+        p = buffer.data();
+      }
+
+      p = putAddress(p, addressCount);
+      for (int i = 0; i < 8; i++, p += 3) memcpy(p, hexBytes.digits[bytes[i]], 3);
+      *p++ = '\n';
+    }
+
+    // The rest starts a new line:
+    if (bytes != end) {
+      p = putAddress(p, addressCount);
+      for (; bytes != end; bytes++, stPos++, p += 3) memcpy(p, hexBytes.digits[*bytes], 3);
+    }
+  }
+
+  fwrite(buffer.data(), 1, p - buffer.data(), outputFile);
+}
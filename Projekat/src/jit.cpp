@@ -0,0 +1,638 @@
+#include "../inc/jit.hpp"
+#include "../inc/devices.hpp"
+
+
+// Host registers used by the generated code: (rbx always holds the address of gpr[])
+enum HostReg {
+  EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESI = 6, EDI = 7
+};
+const unsigned char pcOffset = pc * 4;  // Offset of gpr[pc] from rbx.
+
+typedef JitResult (*JitEntry)(int* gprBase, unsigned char* code);
+
+unsigned char* jitArena = nullptr;  // Starts with the entry stub, translated blocks follow it.
+unsigned char* emitPtr;             // Where the next byte of host code will be written.
+unsigned char* blocksStart;
+
+unordered_map<uint, JitBlock*> jitBlocks;  // Guest start address -> translated block.
+vector<JitExitSlot*> jitSlots;
+JitPage* jitPages[decodedPageCount];
+vector<uint> jitPageNums;                  // Pages that have a JitPage, for flushing.
+
+uint countedInBlock;        // Instructions of the block being translated that were already added to instrCount.
+
+bool jitCodeModified = false;  // Set when the guest overwrites an instruction that was translated.
+ulong jitGeneration = 0;       // Increased on every flush.
+
+
+// Emitting host code:
+void emitByte(unsigned char b) { *emitPtr++ = b; }
+void emitWord32(uint v) { memcpy(emitPtr, &v, 4); emitPtr += 4; }
+void emitWord64(ulong v) { memcpy(emitPtr, &v, 8); emitPtr += 8; }
+void patchRel32(unsigned char* rel, unsigned char* target) {
+  int disp = target - (rel + 4);
+  memcpy(rel, &disp, 4);
+}
+
+  // mov host, gpr[guest]  (guest pc is read as the constant pcValue unless it was already stored to gpr[pc])
+void emitLoadGuest(int host, uint guest, uint pcValue, bool pcInMemory) {
+  if (guest == pc && !pcInMemory) {
+    emitByte(0xB8 + host);
+    emitWord32(pcValue);
+  }
+  else {
+    emitByte(0x8B);
+    emitByte(0x43 | (host << 3));
+    emitByte(guest * 4);
+  }
+}
+  // mov gpr[guest], host
+void emitStoreGuest(uint guest, int host) {
+  emitByte(0x89);
+  emitByte(0x43 | (host << 3));
+  emitByte(guest * 4);
+}
+  // mov dword gpr[guest], imm32
+void emitStoreGuestImm(uint guest, uint imm) {
+  emitByte(0xC7);
+  emitByte(0x43);
+  emitByte(guest * 4);
+  emitWord32(imm);
+}
+  // op dst, src  (op is one of the "op r/m32, r32" opcodes: add 01, or 09, and 21, sub 29, xor 31, cmp 39, mov 89)
+void emitAluRR(unsigned char op, int dst, int src) {
+  emitByte(op);
+  emitByte(0xC0 | (src << 3) | dst);
+}
+  // add host, imm32
+void emitAddImm(int host, uint imm) {
+  if (imm == 0) return;
+  emitByte(0x81);
+  emitByte(0xC0 | host);
+  emitWord32(imm);
+}
+  // movabs host64, imm64
+void emitMovAbs(int host, ulong imm) {
+  emitByte(0x48);
+  emitByte(0xB8 + host);
+  emitWord64(imm);
+}
+  // call fn  (the stack is kept 16B aligned inside blocks)
+void emitCall(void* fn) {
+  emitMovAbs(EAX, (ulong)fn);
+  emitByte(0xFF);
+  emitByte(0xD0);
+}
+  // instrCount += count
+void emitCountAdd(uint count) {
+  if (count == 0) return;
+  emitMovAbs(ECX, (ulong)&instrCount);
+  emitByte(0x48); emitByte(0x81); emitByte(0x01);
+  emitWord32(count);
+}
+  // cmp byte [jitCodeModified], 0
+void emitCheckModified() {
+  emitMovAbs(ECX, (ulong)&jitCodeModified);
+  emitByte(0x80); emitByte(0x39); emitByte(0x00);
+}
+  // jcc rel32, returns where the rel32 has to be patched
+unsigned char* emitJcc(unsigned char cc) {
+  emitByte(0x0F);
+  emitByte(cc);
+  emitWord32(0);
+  return emitPtr - 4;
+}
+  // Return to emulateJit(): (pops what the entry stub pushed)
+void emitEpilogue() {
+  emitByte(0x41); emitByte(0x5C);  // pop r12
+  emitByte(0x5D);                  // pop rbp
+  emitByte(0x5B);                  // pop rbx
+  emitByte(0xC3);                  // ret
+}
+void emitReturn(uint status, JitExitSlot* slot) {
+  if (status == 0) emitAluRR(0x31, EAX, EAX);
+  else {
+    emitByte(0xB8 + EAX);
+    emitWord32(status);
+  }
+  if (slot) emitMovAbs(EDX, (ulong)slot);
+  else emitAluRR(0x31, EDX, EDX);
+  emitEpilogue();
+}
+
+
+// Block exits: (count is the number of guest instructions executed in the block up to and including this exit)
+  // Leave for a fixed guest address:
+void emitExitStatic(uint target, uint count, bool checkModified) {
+  emitStoreGuestImm(pc, target);
+  emitCountAdd(count - countedInBlock);
+
+  unsigned char* toPlainExit = nullptr;
+  if (checkModified) {
+    emitCheckModified();
+    toPlainExit = emitJcc(0x85);  // jne
+  }
+
+  JitExitSlot* slot = new JitExitSlot();
+  jitSlots.push_back(slot);
+  slot->cmpImm = nullptr;
+  emitByte(0xE9);                 // jmp rel32 (until chained, to the return below)
+  emitWord32(0);
+  slot->jmpRel = emitPtr - 4;
+  emitReturn(0, slot);
+
+  if (toPlainExit) {
+    patchRel32(toPlainExit, emitPtr);
+    emitReturn(0, nullptr);
+  }
+}
+  // Leave for the guest address in eax:
+void emitExitDynamic(uint count, bool checkModified) {
+  emitStoreGuest(pc, EAX);
+  emitCountAdd(count - countedInBlock);
+
+  unsigned char* toPlainExit = nullptr;
+  if (checkModified) {
+    emitCheckModified();
+    toPlainExit = emitJcc(0x85);  // jne
+  }
+
+  JitExitSlot* slot = new JitExitSlot();
+  jitSlots.push_back(slot);
+  emitByte(0x3D);                 // cmp eax, imm32 (target that the jump below was chained for)
+  emitWord32(0);
+  slot->cmpImm = emitPtr - 4;
+  unsigned char* toReturn = emitJcc(0x85);  // jne
+  emitByte(0xE9);                 // jmp rel32 (until chained, to the return below)
+  emitWord32(0);
+  slot->jmpRel = emitPtr - 4;
+  patchRel32(toReturn, emitPtr);
+  emitReturn(0, slot);
+
+  if (toPlainExit) {
+    patchRel32(toPlainExit, emitPtr);
+    emitReturn(0, nullptr);
+  }
+}
+  // After a guest write inside of a block: leave if the write hit translated code.
+void emitWriteCheck(uint next, uint count) {
+  emitCheckModified();
+  unsigned char* toContinue = emitJcc(0x84);  // je
+  emitStoreGuestImm(pc, next);
+  emitCountAdd(count - countedInBlock);
+  emitReturn(0, nullptr);
+  patchRel32(toContinue, emitPtr);
+}
+  // Before a guest write: instrCount has to be up to date in case the write reaches a device.
+void emitSyncCount(uint count) {
+  emitCountAdd(count - countedInBlock);
+  countedInBlock = count;
+}
+
+
+// Helpers called from translated code:
+uint jitInt(uint returnAddress) {
+  gpr[pc] = returnAddress;
+  pushCSR(status);
+  pushGPR(pc);
+  csr[cause] = 4;
+  csr[status] = csr[status] & (~0x1);
+  gpr[pc] = csr[handler];
+  deviceStatusWritten();
+  return gpr[pc];
+}
+
+
+// Checks if the instruction word is one that emulate() would execute: (the rest are left to the interpreter to report)
+bool jitRecognized(uint word) {
+  uint opCode = word >> 28;
+  uint mode = (word >> 24) & 0xf;
+
+  switch (opCode) {
+    case 0x0: return word == 0;
+    case 0x1: return word == 0x10000000;
+    case 0x3: return mode <= 3 || (mode >= 8 && mode <= 0xB);
+    case 0x5:
+    case 0x6: return mode <= 3;
+    case 0x9: return mode <= 7;
+    case 0x2:
+    case 0x4:
+    case 0x7:
+    case 0x8: return true;
+    default:  return false;
+  }
+}
+
+// Translates a single instruction, returns true if it ends the block:
+//  (count is the number of block's instructions up to and including this one)
+bool translateInstr(uint address, uint word, uint count) {
+  uint opCode = (word >> 28);
+  uint mode = (word >> 24) & 0xf;
+  uint regA = (word >> 20) & 0xf;
+  uint regB = (word >> 16) & 0xf;
+  uint regC = (word >> 12) & 0xf;
+  uint disp = word & 0xfff;
+  uint next = address + 4;  // Value of pc while the instruction executes.
+
+  // Instructions that write pc end the block. They get pc stored up front and read it back from gpr[pc].
+  bool writesA = (opCode == 0x5 || opCode == 0x6 || (opCode == 0x7 && mode <= 1) || (opCode == 0x9 && mode <= 3));
+  bool writesB = (opCode == 0x4 || (opCode == 0x9 && (mode == 3 || mode == 7)));
+  bool writesC = (opCode == 0x4);
+  bool writesPc = (writesA && regA == pc) || (writesB && regB == pc) || (writesC && regC == pc);
+  bool writesR0 = (writesA && regA == r0) || (writesB && regB == r0) || (writesC && regC == r0);
+  bool writesStatus = (opCode == 0x9 && mode >= 4 && mode <= 7 && regA == status);
+  if (writesPc) emitStoreGuestImm(pc, next);
+
+  #define LOAD(host, guest) emitLoadGuest(host, guest, next, writesPc)
+  // edi = gpr[ra] + gpr[rb] + disp:
+  #define ADDRESS(ra, rb, d) { LOAD(EDI, ra); LOAD(ECX, rb); emitAluRR(0x01, EDI, ECX); emitAddImm(EDI, d); }
+
+  switch (opCode) {
+    // HALT, INT:
+    case 0x0:
+      emitStoreGuestImm(pc, next);
+      emitCountAdd(count - countedInBlock);
+      emitReturn(1, nullptr);
+      return true;
+    case 0x1:
+      emitSyncCount(count);
+      emitByte(0xB8 + EDI);
+      emitWord32(next);
+      emitCall((void*)jitInt);
+      emitExitDynamic(count, true);
+      return true;
+
+    // CALL:
+    case 0x2:
+      LOAD(EAX, sp);
+      emitAddImm(EAX, -4);
+      emitStoreGuest(sp, EAX);
+      emitAluRR(0x89, EDI, EAX);
+      emitByte(0xB8 + ESI);
+      emitWord32(next);
+      emitSyncCount(count);
+      emitCall((void*)writeWord);
+      if (mode == 0) {
+        LOAD(EAX, regA);
+        LOAD(ECX, regB);
+        emitAluRR(0x01, EAX, ECX);
+        emitAddImm(EAX, disp);
+        emitExitDynamic(count, true);
+      }
+      else if (mode == 1) {
+        ADDRESS(regA, regB, disp);
+        emitCall((void*)readWord);
+        emitExitDynamic(count, true);
+      }
+      else emitExitStatic(next, count, true);
+      return true;
+
+    // JMP, BRANCH:
+    case 0x3: {
+      unsigned char* toNotTaken = nullptr;
+      if ((mode & 0x7) != 0) {
+        LOAD(ECX, regB);
+        LOAD(EDX, regC);
+        emitAluRR(0x39, ECX, EDX);
+        if ((mode & 0x7) == 1) toNotTaken = emitJcc(0x85);       // BEQ: jne
+        else if ((mode & 0x7) == 2) toNotTaken = emitJcc(0x84);  // BNE: je
+        else toNotTaken = emitJcc(0x8E);                         // BGT: jle
+      }
+
+      // Taken:
+      if (mode < 8) {
+        if (regA == r0) emitExitStatic(disp, count, false);
+        else if (regA == pc) emitExitStatic(next + disp, count, false);
+        else {
+          LOAD(EAX, regA);
+          emitAddImm(EAX, disp);
+          emitExitDynamic(count, false);
+        }
+      }
+      else {
+        LOAD(EDI, regA);
+        emitAddImm(EDI, disp);
+        emitCall((void*)readWord);
+        emitExitDynamic(count, false);
+      }
+
+      // Not taken:
+      if (toNotTaken) {
+        patchRel32(toNotTaken, emitPtr);
+        emitExitStatic(next, count, false);
+      }
+      return true;
+    }
+
+    // XCHG:
+    case 0x4:
+      LOAD(ECX, regB);
+      LOAD(EDX, regC);
+      emitStoreGuest(regB, EDX);
+      emitStoreGuest(regC, ECX);
+      break;
+
+    // ADD, SUB, MUL, DIV, NOT, AND, OR, XOR, SHL, SHR:
+    case 0x5:
+    case 0x6:
+    case 0x7:
+      if (opCode == 0x7 && mode > 1) break;
+      LOAD(EAX, regB);
+      LOAD(ECX, regC);
+      if (opCode == 0x5) {
+        if (mode == 0) emitAluRR(0x01, EAX, ECX);
+        else if (mode == 1) emitAluRR(0x29, EAX, ECX);
+        else if (mode == 2) { emitByte(0x0F); emitByte(0xAF); emitByte(0xC0 | (EAX << 3) | ECX); }  // imul eax, ecx
+        else { emitByte(0x99); emitByte(0xF7); emitByte(0xF9); }                                   // cdq, idiv ecx
+      }
+      else if (opCode == 0x6) {
+        if (mode == 0) { emitByte(0xF7); emitByte(0xD0); }  // not eax
+        else if (mode == 1) emitAluRR(0x21, EAX, ECX);
+        else if (mode == 2) emitAluRR(0x09, EAX, ECX);
+        else emitAluRR(0x31, EAX, ECX);
+      }
+      else {
+        emitByte(0xD3);
+        emitByte(mode == 0 ? 0xE0 : 0xF8);  // shl eax, cl / sar eax, cl
+      }
+      emitStoreGuest(regA, EAX);
+      break;
+
+    // ST, PUSH:
+    case 0x8:
+      if (mode == 0) {
+        ADDRESS(regA, regB, disp);
+        LOAD(ESI, regC);
+      }
+      else if (mode == 1) {
+        LOAD(EAX, sp);
+        emitAddImm(EAX, -4);
+        emitStoreGuest(sp, EAX);
+        emitAluRR(0x89, EDI, EAX);
+        LOAD(ESI, regC);
+      }
+      else if (mode == 2) {
+        ADDRESS(regA, regB, disp);
+        emitCall((void*)readWord);
+        emitAluRR(0x89, EDI, EAX);
+        LOAD(ESI, regC);
+      }
+      else break;
+      emitSyncCount(count);
+      emitCall((void*)writeWord);
+      emitWriteCheck(next, count);
+      break;
+
+    // LD, CSRWR, CSRRD, POP:
+    case 0x9:
+      switch (mode) {
+        case 0:
+          emitMovAbs(EAX, (ulong)&csr[regB]);
+          emitByte(0x8B); emitByte(0x00);  // mov eax, [rax]
+          emitStoreGuest(regA, EAX);
+          break;
+        case 1:
+          LOAD(EAX, regB);
+          emitAddImm(EAX, disp);
+          emitStoreGuest(regA, EAX);
+          break;
+        case 2:
+          ADDRESS(regB, regC, disp);
+          emitCall((void*)readWord);
+          emitStoreGuest(regA, EAX);
+          break;
+        case 3:
+        case 7:
+          LOAD(EDI, regB);
+          emitCall((void*)readWord);
+          if (mode == 3) emitStoreGuest(regA, EAX);
+          else {
+            emitMovAbs(ECX, (ulong)&csr[regA]);
+            emitByte(0x89); emitByte(0x01);  // mov [rcx], eax
+          }
+          LOAD(EAX, regB);
+          emitAddImm(EAX, disp);
+          emitStoreGuest(regB, EAX);
+          break;
+        case 4:
+          LOAD(ECX, regB);
+          emitMovAbs(EAX, (ulong)&csr[regA]);
+          emitByte(0x89); emitByte(0x08);  // mov [rax], ecx
+          break;
+        case 5:
+          emitMovAbs(EAX, (ulong)&csr[regB]);
+          emitByte(0x8B); emitByte(0x08);  // mov ecx, [rax]
+          emitByte(0x81); emitByte(0xC9);  // or ecx, imm32
+          emitWord32(disp);
+          emitMovAbs(EAX, (ulong)&csr[regA]);
+          emitByte(0x89); emitByte(0x08);  // mov [rax], ecx
+          break;
+        case 6:
+          ADDRESS(regB, regC, disp);
+          emitCall((void*)readWord);
+          emitMovAbs(ECX, (ulong)&csr[regA]);
+          emitByte(0x89); emitByte(0x01);  // mov [rcx], eax
+          break;
+      }
+      break;
+  }
+
+  #undef ADDRESS
+  #undef LOAD
+
+  // Always keep r0 at zero:
+  if (writesR0) emitStoreGuestImm(r0, 0);
+
+  // A write to status can unmask a pending interrupt, which is only accepted between blocks:
+  if (writesStatus) emitCall((void*)deviceStatusWritten);
+
+  if (writesPc) {
+    emitLoadGuest(EAX, pc, next, true);
+    emitExitDynamic(count, false);
+    return true;
+  }
+  if (writesStatus) {
+    emitExitStatic(next, count, false);
+    return true;
+  }
+  return false;
+}
+
+
+// Translates the block starting at the given address: (nullptr if its first instruction has to be interpreted)
+JitBlock* jitTranslate(uint start) {
+  if ((start & 0x3) || !jitRecognized(readWord(start))) return nullptr;
+
+  // (one more than maxBlockInstrs for the entry check and the final exit)
+  if (emitPtr + (maxBlockInstrs + 1) * maxInstrCodeSize > jitArena + jitArenaSize) jitFlush();
+
+  JitBlock* block = new JitBlock();
+  block->start = start;
+  block->code = emitPtr;
+  countedInBlock = 0;
+
+  // Leave right away if the block could run past the next device event: (emulateJit() then interprets up to it)
+  emitMovAbs(ECX, (ulong)&instrCount);
+  emitByte(0x48); emitByte(0x8B); emitByte(0x01);  // mov rax, [rcx]
+  emitByte(0x48); emitByte(0x05);                  // add rax, imm32 (block's length, patched below)
+  emitWord32(0);
+  unsigned char* lengthImm = emitPtr - 4;
+  emitMovAbs(ECX, (ulong)&eventDeadline);
+  emitByte(0x48); emitByte(0x3B); emitByte(0x01);  // cmp rax, [rcx]
+  unsigned char* toDeadlineExit = emitJcc(0x87);   // ja
+
+  uint address = start;
+  uint count = 0;
+  while (true) {
+    uint word = readWord(address);
+    if (!jitRecognized(word)) {
+      emitExitStatic(address, count, false);
+      break;
+    }
+
+    count++;
+    bool ends = translateInstr(address, word, count);
+    address += 4;
+    if (ends) break;
+
+    if (count == maxBlockInstrs || (address & pageMask) == 0) {
+      emitExitStatic(address, count, false);
+      break;
+    }
+  }
+  block->end = address;
+
+  uint length = (block->end - block->start) / 4;
+  memcpy(lengthImm, &length, 4);
+  patchRel32(toDeadlineExit, emitPtr);
+  emitStoreGuestImm(pc, start);
+  emitReturn(0, nullptr);
+
+  // Remember which guest words were translated, so that writes to them can be caught:
+  uint pageNum = start >> pageBits;
+  if (!jitPages[pageNum]) {
+    jitPages[pageNum] = new JitPage();
+    jitPageNums.push_back(pageNum);
+  }
+  for (uint a = start; a != block->end; a += 4) {
+    jitPages[pageNum]->words[(a & pageMask) >> 2] = true;
+  }
+
+  jitBlocks[start] = block;
+  return block;
+}
+
+// Patches the exit slot to jump straight into the given block:
+void jitChain(JitExitSlot* slot, uint target, JitBlock* block) {
+  if (slot->cmpImm) memcpy(slot->cmpImm, &target, 4);
+  patchRel32(slot->jmpRel, block->code);
+}
+
+
+// Allocates the executable arena and writes the entry stub at its start:
+int jitInit() {
+  int prot = PROT_READ | PROT_WRITE | PROT_EXEC;
+  jitArena = (unsigned char*)mmap(nullptr, jitArenaSize, prot, MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (jitArena == MAP_FAILED) {
+    jitArena = nullptr;
+    fprintf(stderr, "Emulator error: couldn't allocate memory for translated code.\n");
+    return -1;
+  }
+
+  // Entry stub: JitResult entry(int* gprBase, unsigned char* code)
+  emitPtr = jitArena;
+  emitByte(0x53);                                     // push rbx
+  emitByte(0x55);                                     // push rbp
+  emitByte(0x41); emitByte(0x54);                     // push r12  (3 pushes keep rsp 16B aligned for calls)
+  emitByte(0x48); emitByte(0x89); emitByte(0xFB);     // mov rbx, rdi
+  emitByte(0xFF); emitByte(0xE6);                     // jmp rsi
+  blocksStart = emitPtr;
+
+  return 0;
+}
+
+// Called for every guest write, drops translated code if one of its instructions gets overwritten:
+void jitNoteWrite(uint address) {
+  JitPage* page = jitPages[address >> pageBits];
+  if (page && page->words[(address & pageMask) >> 2]) jitCodeModified = true;
+
+  // An unaligned write also reaches into the next word (which can be on the next page):
+  if (address & 0x3) {
+    address += 4;
+    page = jitPages[address >> pageBits];
+    if (page && page->words[(address & pageMask) >> 2]) jitCodeModified = true;
+  }
+}
+
+// Throws away all translated blocks:
+void jitFlush() {
+  for (unordered_map<uint, JitBlock*>::iterator it = jitBlocks.begin(); it != jitBlocks.end(); it++) delete it->second;
+  jitBlocks.clear();
+  for (JitExitSlot* slot : jitSlots) delete slot;
+  jitSlots.clear();
+  for (uint pageNum : jitPageNums) {
+    delete jitPages[pageNum];
+    jitPages[pageNum] = nullptr;
+  }
+  jitPageNums.clear();
+
+  emitPtr = blocksStart;
+  jitCodeModified = false;
+  jitGeneration++;
+}
+
+void jitFree() {
+  if (!jitArena) return;
+  jitFlush();
+  munmap(jitArena, jitArenaSize);
+  jitArena = nullptr;
+}
+
+
+// Emulate: (same results as emulate(), but runs translated blocks)
+int emulateJit() {
+  if (!jitArena && jitInit() == -1) return -1;
+
+  JitExitSlot* slot = nullptr;  // Exit of the previous block that can be chained to the next one.
+  while (true) {
+    // Device events: (an interrupt moves pc, so the previous block's exit can't be chained)
+    if (instrCount >= eventDeadline) {
+      handleEvents();
+      slot = nullptr;
+    }
+    if (jitCodeModified) {
+      jitFlush();
+      slot = nullptr;
+    }
+
+    uint address = (uint)gpr[pc];
+    JitBlock* block = nullptr;
+    unordered_map<uint, JitBlock*>::iterator it = jitBlocks.find(address);
+    if (it != jitBlocks.end()) block = it->second;
+    else if (instrCount + maxBlockInstrs <= eventDeadline) {  // Close to an event, the instructions are interpreted.
+      ulong generation = jitGeneration;
+      block = jitTranslate(address);
+      if (generation != jitGeneration) slot = nullptr;  // Translating flushed the arena.
+    }
+
+    // Instructions that can't be translated are executed by the interpreter, as well as
+    //  the ones right before a device event when the whole block doesn't fit before it:
+    if (!block || instrCount + (block->end - block->start) / 4 > eventDeadline) {
+      DecodedInstr di;
+      gpr[pc] += 4;
+      decodeInstr(readWord(address), di);
+      instrCount++;
+      int res = di.handler(di);
+      if (res == 1) return 0;
+      if (res == -1) return -1;
+      gpr[r0] = 0;
+      slot = nullptr;
+      continue;
+    }
+
+    if (slot) jitChain(slot, address, block);
+    JitResult result = ((JitEntry)jitArena)(gpr, block->code);
+    if (result.status == 1) return 0;  // HALT.
+    slot = result.slot;
+  }
+}
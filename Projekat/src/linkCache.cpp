@@ -0,0 +1,107 @@
+#include "../inc/linkCache.hpp"
+
+
+// Binary file support:
+void LinkCache::bWrite(std::ofstream& file) {
+  bWriteHeader(file, linkCacheMagic);
+  stringTable.bWrite(file);
+
+  bWriteUint(file, placeOptions.size());
+  for (pair<uint, uint>& p : placeOptions) {
+    bWriteUint(file, p.first);
+    bWriteUint(file, p.second);
+  }
+  bWriteUlong(file, outputHash);
+
+  bWriteUint(file, files.size());
+  for (LinkCacheFile& f : files) {
+    bWriteString(file, f.fileName);
+    bWriteUlong(file, f.hash);
+
+    bWriteUint(file, f.sections.size());
+    file.write((char*)f.sections.data(), f.sections.size() * sizeof(LinkCacheSection));
+    bWriteUint(file, f.globals.size());
+    file.write((char*)f.globals.data(), f.globals.size() * sizeof(pair<uint, uint>));
+    bWriteUint(file, f.globalSites.size());
+    file.write((char*)f.globalSites.data(), f.globalSites.size() * sizeof(pair<uint, uint>));
+  }
+
+  resSymbolTable.bWrite(file);
+}
+
+int LinkCache::bRead(std::ifstream& file) {
+  uint magic = bReadUint(file);
+  uint version = bReadUint(file);
+  if (file.fail() || magic != linkCacheMagic || version != binaryFileVersion) return -1;
+
+  vector<string> names;
+  vector<uint> fileIds;
+  StringTable::bReadNames(file, names);
+  if (file.fail()) return -1;
+  stringTable.intern(names, fileIds);
+
+  uint len = bReadUint(file);
+  for (uint i = 0; i < len && !file.fail(); i++) {
+    uint sectName = bReadId(file, fileIds);
+    placeOptions.push_back(make_pair(sectName, bReadUint(file)));
+  }
+  outputHash = bReadUlong(file);
+
+  len = bReadUint(file);
+  for (uint i = 0; i < len && !file.fail(); i++) {
+    files.push_back(LinkCacheFile());
+    LinkCacheFile& f = files.back();
+    bReadString(file, f.fileName);
+    f.hash = bReadUlong(file);
+
+    uint count = bReadUint(file);
+    if (file.fail()) return -1;
+    f.sections.resize(count);
+    file.read((char*)f.sections.data(), count * sizeof(LinkCacheSection));
+    count = bReadUint(file);
+    if (file.fail()) return -1;
+    f.globals.resize(count);
+    file.read((char*)f.globals.data(), count * sizeof(pair<uint, uint>));
+    count = bReadUint(file);
+    if (file.fail()) return -1;
+    f.globalSites.resize(count);
+    file.read((char*)f.globalSites.data(), count * sizeof(pair<uint, uint>));
+    if (file.fail()) return -1;
+
+    // Names in the blocks above are ids into the cache's string table as well:
+    for (LinkCacheSection& s : f.sections) {
+      if (s.name >= fileIds.size()) return -1;
+      s.name = fileIds[s.name];
+    }
+    for (pair<uint, uint>& g : f.globals) {
+      if (g.first >= fileIds.size()) return -1;
+      g.first = fileIds[g.first];
+    }
+    for (pair<uint, uint>& site : f.globalSites) {
+      if (site.second >= fileIds.size()) return -1;
+      site.second = fileIds[site.second];
+    }
+  }
+
+  resSymbolTable.bRead(file, fileIds);
+  if (file.fail()) return -1;
+
+  return 0;
+}
+
+
+// Hash of a file's content: (64bit FNV-1a)
+int hashFile(string path, ulong& hash) {
+  ifstream in(path, ios::binary);
+  if (in.fail()) return -1;
+
+  hash = 0xcbf29ce484222325;
+  vector<char> buffer(1 << 16);
+  while (in) {
+    in.read(buffer.data(), buffer.size());
+    for (streamsize i = 0; i < in.gcount(); i++) {
+      hash = (hash ^ (unsigned char)buffer[i]) * 0x100000001b3;
+    }
+  }
+  return 0;
+}
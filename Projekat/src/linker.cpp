@@ -2,28 +2,45 @@
 
 
 vector<string> inputFileNames;
+vector<string> archiveFileNames;  // Searched for members that define undefined extern symbols, after all input files.
+vector<Archive> archives;
 string outputFileName = "";
-
-SymbolTable curSymbolTable;
+uint threadCount = 1;  // Input files are read and relocated by this many threads. ('-j' option)
+bool incrementalOption = false;  // Relink from the previous link's cache if possible. ('-incremental' option)
+bool gcSectionsOption = false;   // Drop sections nothing refers to. ('--gc-sections' option)
+bool dedupPoolsOption = false;   // Merge identical pool entries of nearby sections. ('--dedup-pools' option)
+uint entrySymbol = undId;        // Sections are reachable from the one this global symbol is in. ('-entry=' option)
+string mapFileName = "";         // Where sections and symbols landed, and phase timings. ('-Map' option)
+const uint entryAddress = 0x40000000;  // Where the emulator starts executing, if no entry symbol is given.
+LinkCache linkCache;
+
+vector<InputFile> inputFiles;  // In their argv order.
 SectionTable curSectionTable;
-RelocationTables curRelocationTables;
 
-vector<SymbolTable> asmSymbolTables;    // SymbolTables from all input files in their argv order.
-vector<RelocationTables> asmRelTables;  // RelocationTables from all input files in their argv order.
 
 uint locCounter = 0;
 uint maxPlacedAddress = 0;
 
-unordered_map<string, uint> placedSections; // Names of sections that were given a '-place' option.  (sectName -> placedAddress)
-multiset<Section> processedSections; // Sections sorted by base value, but their relocations aren't yet taken care of.
-vector<Section> finishedSections;    // ProcessedSections that have their SymbolTable and RelocationTable taken care of.
+unordered_map<uint, uint> placedSections; // Names of sections that were given a '-place' option.  (sectName -> placedAddress)
+multimap<uint, uint> placeAddresses;       // The same options sorted by address.  (placedAddress -> sectName)
+vector<SectionGroup> sectionGroups;        // Same-named sections from all input files, in the order of first appearance.
+unordered_map<uint, uint> sectionGroupIds;  // sectName -> index in sectionGroups
+vector<Section> processedSections; // Sections sorted by base value, but their relocations aren't yet taken care of.
 
 SymbolTable resSymbolTable; // SymbolTable that is the result of linker's process (contains only global symbols). 
 
 vector<MemoryContent> memoryContents; // Merged contents of successive sections. For writing binary output file.
+char* outputImage = nullptr;  // The binary output file mapped into memory, memoryContents point into it.
+ulong outputImageSize = 0;
+int outputFd = -1;
 
 ulong totalContentSize;  // To check if the total content size is larger than 2^32 bytes (the host's emulation memory).
 const ulong maxTotalSize = (ulong)1 << 32; 
+const uint maxDisp = 0xfff;  // Displacements in machine instructions are 12 bit unsigned.
+
+chrono::steady_clock::time_point linkStart;   // For the phase timings in the '-Map' file.
+chrono::steady_clock::time_point phaseStart;
+vector<pair<string, double>> phaseTimes;      // <phase, milliseconds> in the order they ran.
 
 
 // Remember inputFileNames, outputFileName, which sections were given the -place option:
@@ -38,6 +55,11 @@ int processCommandLineArguments(int argc, char* argv[]) {
       && strcmp(string(argv[i]).substr(string(argv[i]).length() - 2).c_str(), ".o") == 0) {
         inputFileNames.push_back(argv[i]);
       }
+      // Archive:
+      else if (argv[i][0] != '-' && string(argv[i]).length() > 2 
+      && strcmp(string(argv[i]).substr(string(argv[i]).length() - 2).c_str(), ".a") == 0) {
+        archiveFileNames.push_back(argv[i]);
+      }
       // Option '-o':
       else if (strcmp(argv[i], "-o") == 0) {
         // If argument '-o' isn't followed by a file name: (if '-o' is the last argument or if it's followed by another option)  
@@ -51,7 +73,7 @@ int processCommandLineArguments(int argc, char* argv[]) {
       else if (strcmp(string(argv[i]).substr(0, 7).c_str(), "-place=") == 0) {
         string s = argv[i];
         int delimiter = s.find("@");
-        string sectName = s.substr(7, delimiter - 7);
+        uint sectName = stringTable.intern(s.substr(7, delimiter - 7));
         uint address = stoul(s.substr(delimiter + 1), 0, 16);
 
         if (placedSections.find(sectName) != placedSections.end()) {
@@ -59,13 +81,49 @@ int processCommandLineArguments(int argc, char* argv[]) {
           return -1;
         }
         placedSections.insert(make_pair(sectName, address));
+        placeAddresses.insert(make_pair(address, sectName));
 
         if (address > maxPlacedAddress) maxPlacedAddress = address;
       }
+      // Option '-j':
+      else if (strcmp(argv[i], "-j") == 0) {
+        if (i == argc - 1 || atoi(argv[i+1]) < 1) {
+          inputErr = true;
+          break;
+        }
+        threadCount = atoi(argv[++i]);
+      }
       // Option '-hex':
       else if (strcmp(argv[i], "-hex") == 0) {
         hexOption = true;
       }
+      // Option '--gc-sections':
+      else if (strcmp(argv[i], "--gc-sections") == 0) {
+        gcSectionsOption = true;
+      }
+      // Option '--dedup-pools':
+      else if (strcmp(argv[i], "--dedup-pools") == 0) {
+        dedupPoolsOption = true;
+      }
+      // Option '-entry':
+      else if (strcmp(string(argv[i]).substr(0, 7).c_str(), "-entry=") == 0 && string(argv[i]).length() > 7) {
+        entrySymbol = stringTable.intern(string(argv[i]).substr(7));
+      }
+      // Option '-Map':  (-Map=file or -Map file)
+      else if (strcmp(string(argv[i]).substr(0, 5).c_str(), "-Map=") == 0 && string(argv[i]).length() > 5) {
+        mapFileName = string(argv[i]).substr(5);
+      }
+      else if (strcmp(argv[i], "-Map") == 0) {
+        if (i == argc - 1 || argv[i+1][0] == '-') {
+          inputErr = true;
+          break;
+        }
+        mapFileName = argv[++i];
+      }
+      // Option '-incremental':
+      else if (strcmp(argv[i], "-incremental") == 0) {
+        incrementalOption = true;
+      }
       else inputErr = true;
     }
   }
@@ -84,286 +142,864 @@ int processCommandLineArguments(int argc, char* argv[]) {
   return 0;
 }
 
-// Reads a single assembler's binary output: (curSymbolTable, curSectionTable, curRelocationTable)
-int readAssemblerFile(string fileName) {
+// Reads the header and the string table of an assembler's binary output:
+void readAssemblerFileNames(InputFile& file) {
   string prefix = "../tests/";
-  ifstream in(prefix + fileName);
+  ifstream in(prefix + file.path, ios::binary);
   if (in.fail()) {
     fprintf(stderr, "Linker Error: couldn't find a file with the given filename in the 'tests' directory.");
-    return -1;
+    file.status = -1;
+    return;
+  }
+  in.seekg(file.offset);
+  if (bCheckHeader(in, objectFileMagic, file.fileName) == -1) {
+    file.status = -1;
+    return;
   }
 
-  curSymbolTable = SymbolTable();
-  curSymbolTable.bRead(in);
-  curSectionTable = SectionTable();
-  curSectionTable.bRead(in);
-  //curSectionTable.printSectionTables(stdout);
-  curRelocationTables = RelocationTables();
-  curRelocationTables.bRead(in);
+  StringTable::bReadNames(in, file.names);
+  file.tablesStart = in.tellg();
 
-  in.close();
+  if (in.fail()) {
+    fprintf(stderr, "Linker Error: %s is truncated.\n", file.fileName.c_str());
+    file.status = -1;
+  }
+}
+
+// Reads the tables of an assembler's binary output: (names are already interned into file.fileIds)
+void readAssemblerFileTables(InputFile& file) {
+  string prefix = "../tests/";
+  ifstream in(prefix + file.path, ios::binary);
+  in.seekg(file.tablesStart);
+
+  file.symbolTable.bRead(in, file.fileIds);
+  file.sectionTable.bRead(in, file.fileIds);
+  file.relocationTables.bRead(in, file.fileIds);
+
+  if (in.fail()) {
+    fprintf(stderr, "Linker Error: %s is truncated.\n", file.fileName.c_str());
+    file.status = -1;
+  }
+}
+
+// Calls work for every input file, on threadCount threads: (returns -1 if it failed for any of them)
+int forEachInputFile(void (*work)(InputFile&), uint first) {
+  atomic<uint> next(first);
+  auto worker = [&]() {
+    for (uint i = next++; i < inputFiles.size(); i = next++) {
+      if (inputFiles[i].status == 0 && !inputFiles[i].cached) work(inputFiles[i]);
+    }
+  };
 
+  vector<thread> threads;
+  for (uint t = 1; t < threadCount && first + t < inputFiles.size(); t++) {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread& t : threads) t.join();
+
+  for (InputFile& file : inputFiles) {
+    if (file.status == -1) return -1;
+  }
   return 0;
 }
 
-// Moves bases of all placed sections starting form the given address for the given amount of bytes:
-void moveSectionsAfterAddress(uint address, uint forAmount) {
-  multiset<Section> set;
-  multiset<Section>::iterator iter;
-  for (iter = processedSections.begin(); iter->getBase() < address; iter++) {
-    set.insert(*iter);
-  }
-  for (; iter != processedSections.end(); iter++) {
-    Section sec = *iter;
-    sec.setBase(sec.getBase() + forAmount);
-    set.insert(sec);
-  }
-
-  processedSections = set;
-  // cout<< "New order:  " << endl;
-  // for (iter = set.begin(); iter != set.end(); iter++) {
-  //   cout<< "name: " << iter->getName() << " base: " << iter->getBase() << " content: " << iter->getContent().size() << endl;
-  // }
-  locCounter += forAmount;
+// Starts inputFiles over with just the names of the input files:
+void initInputFiles() {
+  inputFiles.clear();
+  inputFiles.resize(inputFileNames.size());
+  for (uint i = 0; i < inputFileNames.size(); i++) {
+    inputFiles[i].fileName = inputFileNames[i];
+    inputFiles[i].path = inputFileNames[i];
+  }
+}
+
+// Reads all assembler's binary outputs: (inputFiles from first on, except the cached ones)
+//  Files are read concurrently, only interning their names into stringTable is done on this thread and in argv order,
+//  so that ids don't depend on which thread finished first.
+int readAssemblerFiles(uint first) {
+  if (forEachInputFile(readAssemblerFileNames, first) == -1) return -1;
+
+  // Names in a file's tables are ids into the file's own string table, map them to ids in stringTable:
+  for (uint i = first; i < inputFiles.size(); i++) {
+    stringTable.intern(inputFiles[i].names, inputFiles[i].fileIds);
+    inputFiles[i].names.clear();
+  }
+
+  return forEachInputFile(readAssemblerFileTables, first);
+}
+
+// Reads the index of every archive given to the linker:
+int readArchives() {
+  string prefix = "../tests/";
+  archives.resize(archiveFileNames.size());
+  for (uint i = 0; i < archiveFileNames.size(); i++) {
+    archives[i].fileName = archiveFileNames[i];
+
+    ifstream in(prefix + archiveFileNames[i], ios::binary);
+    if (in.fail()) {
+      fprintf(stderr, "Linker Error: couldn't find %s in the 'tests' directory.\n", archiveFileNames[i].c_str());
+      return -1;
+    }
+    if (archives[i].bReadIndex(in) == -1) return -1;
+    archives[i].buildSymbolIndex();
+  }
+
+  return 0;
+}
+
+// Adds archive members that define extern symbols still undefined to inputFiles, until no more members are needed:
+//  Members are only read if they are needed, extracted members can need more members in turn.
+int extractArchiveMembers() {
+  if (archives.empty()) return 0;
+
+  SymbolTable definedGlobals;  // Global symbols of inputFiles read so far, only names matter.
+  vector<uint> undefined;
+  uint first = 0;
+
+  while (first < inputFiles.size()) {
+    // Global symbols of newly read files:
+    for (uint i = first; i < inputFiles.size(); i++) {
+      if (inputFiles[i].symbolTable.exportGlobalSymbols(definedGlobals) == -1) return -1;
+    }
+
+    // Extern symbols that are still undefined:
+    vector<uint> stillUndefined;
+    for (uint symName : undefined) {
+      if (!definedGlobals.lookFor(symName)) stillUndefined.push_back(symName);
+    }
+    for (uint i = first; i < inputFiles.size(); i++) {
+      inputFiles[i].symbolTable.checkForUndefinedExtern(definedGlobals, &stillUndefined);
+    }
+    sort(stillUndefined.begin(), stillUndefined.end());
+    stillUndefined.erase(unique(stillUndefined.begin(), stillUndefined.end()), stillUndefined.end());
+    undefined = std::move(stillUndefined);
+
+    // Members that define them: (from the first archive that has a definition)
+    vector<pair<uint, uint>> needed;  // <archive, member>
+    for (uint symName : undefined) {
+      for (uint a = 0; a < archives.size(); a++) {
+        unordered_map<uint, uint>::iterator it = archives[a].symbolIndex.find(symName);
+        if (it == archives[a].symbolIndex.end()) continue;
+
+        if (!archives[a].members[it->second].extracted) {
+          archives[a].members[it->second].extracted = true;
+          needed.push_back(make_pair(a, it->second));
+        }
+        break;
+      }
+    }
+    if (needed.empty()) break;
+
+    // Read them after the files read so far, in the order they are in the archives:
+    sort(needed.begin(), needed.end());
+    first = inputFiles.size();
+    for (pair<uint, uint>& n : needed) {
+      ArchiveMember& member = archives[n.first].members[n.second];
+      inputFiles.push_back(InputFile());
+      inputFiles.back().fileName = archives[n.first].fileName + "(" + member.name + ")";
+      inputFiles.back().path = archives[n.first].fileName;
+      inputFiles.back().offset = member.offset;
+    }
+    if (readAssemblerFiles(first) == -1) return -1;
+  }
+
+  // Undefined extern symbols that no archive defines are reported with the rest of the link errors.
+  return 0;
+}
+
+// Removes sections that can't be reached through relocations from the entry point: ('--gc-sections' option)
+//  The entry point is the section of the '-entry' symbol, or else the section placed at entryAddress.
+//  A relocation reaches the section of the symbol it refers to, in its own file or in the file that defines it as global.
+int collectGarbageSections() {
+  // Where global symbols are defined:  symName -> <file, section>
+  unordered_map<uint, pair<uint, uint>> globalDefinitions;
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    for (const pair<const uint, SymbolTableEntry>& sym : inputFiles[i].symbolTable.getSymbols()) {
+      if (sym.second.type == 'g') globalDefinitions.insert(make_pair(sym.first, make_pair(i, sym.second.section)));
+    }
+  }
+
+  vector<unordered_set<uint>> reachable(inputFiles.size());  // Per file, names of its sections that are used.
+  vector<pair<uint, uint>> toVisit;                             // <file, section>
+
+  // Entry point:
+  if (entrySymbol != undId) {
+    unordered_map<uint, pair<uint, uint>>::iterator it = globalDefinitions.find(entrySymbol);
+    if (it == globalDefinitions.end()) {
+      fprintf(stderr, "Linker Error: entry symbol %s isn't defined as global.\n", stringTable.name(entrySymbol).c_str());
+      return -1;
+    }
+    toVisit.push_back(it->second);
+  }
+  else {
+    for (multimap<uint, uint>::iterator itPlac = placeAddresses.find(entryAddress); itPlac != placeAddresses.end() && itPlac->first == entryAddress; itPlac++) {
+      for (uint i = 0; i < inputFiles.size(); i++) {
+        if (inputFiles[i].sectionTable.lookFor(itPlac->second)) toVisit.push_back(make_pair(i, itPlac->second));
+      }
+    }
+    if (toVisit.empty()) {
+      fprintf(stderr, "Linker Error: '--gc-sections' needs a section placed at 0x%X or an '-entry=' option.\n", entryAddress);
+      return -1;
+    }
+  }
+
+  // Follow relocations:
+  while (!toVisit.empty()) {
+    pair<uint, uint> cur = toVisit.back();
+    toVisit.pop_back();
+    InputFile& file = inputFiles[cur.first];
+    if (!file.sectionTable.lookFor(cur.second) || !reachable[cur.first].insert(cur.second).second) continue;
+
+    for (const pair<uint, uint>& entry : file.relocationTables.getRelTable(cur.second).getEntries()) {
+      SymbolTableEntry* sym = file.symbolTable.lookFor(entry.first);
+      if (sym && sym->getType() != 'e') {
+        toVisit.push_back(make_pair(cur.first, sym->getSection()));
+        continue;
+      }
+
+      unordered_map<uint, pair<uint, uint>>::iterator it = globalDefinitions.find(entry.first);
+      if (it != globalDefinitions.end()) toVisit.push_back(it->second);
+    }
+  }
+
+  // Remove the rest: (and the symbols defined in them, so they don't end up in the resulting SymbolTable)
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    vector<uint> sectNames = inputFiles[i].sectionTable.getSectionOrder();
+    for (uint sectName : sectNames) {
+      if (reachable[i].find(sectName) == reachable[i].end()) {
+        inputFiles[i].sectionTable.removeSection(sectName);
+        inputFiles[i].symbolTable.removeSymbolsOfSection(sectName);
+      }
+    }
+
+    // Externs are only needed if a kept section still relocates against them:
+    unordered_set<uint> usedSymbols;
+    for (uint sectName : inputFiles[i].sectionTable.getSectionOrder()) {
+      for (const pair<uint, uint>& entry : inputFiles[i].relocationTables.getRelTable(sectName).getEntries()) usedSymbols.insert(entry.first);
+    }
+    inputFiles[i].symbolTable.removeUnusedExterns(usedSymbols);
+  }
+
+  return 0;
 }
 
-// Puts sections from curSectionTable in the correct position among all other sections:
+// Collects sections from curSectionTable into groups of same-named sections: (in the order they appear in)
 int placeSection() {
 
-  for (string sectName : curSectionTable.getSectionOrder()) {
+  for (uint sectName : curSectionTable.getSectionOrder()) {
     /* getSections return a map reference, not a copy */
-    unordered_map<string, Section>::iterator it = curSectionTable.getSections().find(sectName);
-    Section curSec = it->second;
+    Section& curSec = curSectionTable.getSections().find(sectName)->second;
+    uint size = curSec.getContent().size();
 
     // If a section has no content, skip it:
-    if (curSec.getContent().size() == 0) {
+    if (size == 0) {
       continue; 
     }
     // Check if the resulting content will be too large for host's emulation memory:
-    totalContentSize += curSec.getContent().size();
+    totalContentSize += size;
     if (totalContentSize > maxTotalSize) {
       fprintf(stderr, "Linker Error: resulting content size won't fit into the host's emulation memory (it's larger than 2^32 bytes).\n");
       return -1;
     }
+
+    unordered_map<uint, uint>::iterator itGroup = sectionGroupIds.find(sectName);  // sectName -> index in sectionGroups
+    if (itGroup == sectionGroupIds.end()) {
+      itGroup = sectionGroupIds.insert(make_pair(sectName, sectionGroups.size())).first;
+      sectionGroups.push_back(SectionGroup(sectName));
+    }
+
+    SectionGroup& group = sectionGroups[itGroup->second];
+    group.sections.push_back(std::move(curSec));
+    group.size += size;
+  }
     
-    unordered_map<std::string, uint>::iterator itPlac = placedSections.find(curSec.getName());  // secName -> address
-
-    // There was NO -PLACE OPTION for this section:
-    if (itPlac == placedSections.end()) {
-      // Look for the last processed section with the same name.
-      multiset<Section>::reverse_iterator itProc = processedSections.rbegin();
-      uint address = -1;
-      for (; itProc != processedSections.rend(); itProc++) {
-        if (strcmp(curSec.getName().c_str(), itProc->getName().c_str()) == 0) {
-          address = itProc->getBase() + itProc->getContent().size();
-          break;
-        }
-      }
-      //  If found, move all sections after it (they are certainly non -placed sections) and insert curSection.
-      if (address != -1) {
-        if (itProc != processedSections.rbegin()) moveSectionsAfterAddress(address, curSec.getContent().size());
-        it->second.setBase(address);
-      }
-      //  If not found, insert curSection at the end (on locCounter).
-      else {
-        it->second.setBase(locCounter);
-        locCounter += it->second.getContent().size();
+  return 0;
+}
+
+// Merges identical pool entries of sections in the same group, where the instructions using them can reach: ('--dedup-pools' option)
+//  Sections of a group are placed one after another, so distances between them are known before layoutSections.
+//  Entries are identical if they hold the same literal, the same global symbol, or the same local symbol of the same file.
+//  Displacements are unsigned, so an instruction can only use an entry after it: sections are handled from the last one,
+//  and an entry is dropped if an identical one in a later section is at most maxDisp bytes away from all its users.
+void dedupPools() {
+  for (SectionGroup& group : sectionGroups) {
+    unordered_map<ulong, uint> keptEntries;  // Entry's key -> distance from the closest kept entry to the group's end
+    uint tailSize = 0;  // Size of the sections after the current one.
+
+    for (vector<Section>::reverse_iterator sec = group.sections.rbegin(); sec != group.sections.rend(); sec++) {
+      uint oldSize = sec->getContent().size();
+      dedupSectionPool(*sec, tailSize, keptEntries);
+
+      group.size -= oldSize - sec->getContent().size();
+      totalContentSize -= oldSize - sec->getContent().size();
+      tailSize += sec->getContent().size();
+    }
+  }
+}
+
+// Drops a section's pool entries that are merged with one after it, and moves the rest together:
+//  (keptEntries maps an entry's key to its distance from the group's end, tailSize is the size of the sections after this one)
+void dedupSectionPool(Section& sec, uint tailSize, unordered_map<ulong, uint>& keptEntries) {
+  InputFile& file = inputFiles[sec.getAsmFileId()];
+  uint length = sec.getLength();
+  const vector<char>& content = sec.getContent();
+  uint slotCount = (content.size() - length) / 4;  // Pool entries are 4 byte slots after the machine instructions.
+  if (slotCount == 0) return;
+
+  // Key of the entry in every slot:  <kind (literal, global or local symbol), file, value or symName>
+  vector<ulong> keys(slotCount);
+  for (const pair<const int, uint>& lit : sec.getPoolEntriesLit()) {
+    keys[(lit.second - length) / 4] = (uint)lit.first;
+  }
+  for (const pair<const uint, uint>& sym : sec.getPoolEntriesSym()) {
+    SymbolTableEntry* entry = file.symbolTable.lookFor(sym.first);
+    if (entry && entry->getType() == 'l') keys[(sym.second - length) / 4] = (2ul << 62) | ((ulong)sec.getAsmFileId() << 32) | sym.first;
+    else keys[(sym.second - length) / 4] = (1ul << 62) | sym.first;
+  }
+
+  // The first instruction that uses each slot is the furthest from it:
+  vector<uint> firstUser(slotCount, content.size());
+  for (uint position : sec.getPoolRefs()) {
+    uint instr;
+    memcpy(&instr, content.data() + position, sizeof(uint));
+    uint target = position + 4 + (instr & maxDisp);
+
+    // Pool of a section larger than maxDisp can be out of its instructions' reach, leave such a section as it is:
+    if (target < length || target >= content.size()) {
+      for (uint slot = 0; slot < slotCount; slot++) {
+        keptEntries[keys[slot]] = content.size() - (length + 4 * slot) + tailSize;
       }
+      return;
+    }
+
+    uint slot = (target - length) / 4;
+    if (position < firstUser[slot]) firstUser[slot] = position;
+  }
+
+  // Decide which entries are merged: (distances are checked as if the section kept its whole pool, it can only get closer)
+  vector<int> newLocations(slotCount);  // New location of the slot's entry in the section, or -1 if it's merged.
+  vector<uint> mergedWith(slotCount);   // Distance of the identical entry from the group's end.
+  uint newSize = length;
+  for (uint slot = 0; slot < slotCount; slot++) {
+    unordered_map<ulong, uint>::iterator itKept = keptEntries.find(keys[slot]);
+    if (itKept != keptEntries.end() && (ulong)content.size() - (firstUser[slot] + 4) + tailSize - itKept->second <= maxDisp) {
+      newLocations[slot] = -1;
+      mergedWith[slot] = itKept->second;
     }
-    // There was a -PLACE OPTION for this section:
     else {
-      uint initialAddress = itPlac->second;
-      uint address = initialAddress;
-
-      // Look for the last processed section with the same name, and increase the address accordingly:
-      //  If there is no processed section with the same name, stop at the first section with <= base address.
-      multiset<Section>::reverse_iterator itProc = processedSections.rbegin();
-      for (; itProc != processedSections.rend(); itProc++) {
-        if (strcmp(curSec.getName().c_str(), itProc->getName().c_str()) == 0) {
-          address = itProc->getBase() + itProc->getContent().size();
-          break;
-        }
-        if (itProc->getBase() <= address) {
-          break;
-        }
-      }
+      newLocations[slot] = newSize;
+      newSize += 4;
+    }
+  }
+  for (uint slot = 0; slot < slotCount; slot++) {
+    if (newLocations[slot] != -1) keptEntries[keys[slot]] = newSize - newLocations[slot] + tailSize;
+  }
+  if (newSize == content.size()) return;
 
-      // Check for overlap with a further -place section:
-      for (unordered_map<std::string, uint>::iterator itPlaced = placedSections.begin(); itPlaced != placedSections.end(); itPlaced++) {
-        if (strcmp(itPlaced->first.c_str(), curSec.getName().c_str()) != 0) {
-          if (itPlaced->second > initialAddress && address + curSec.getContent().size() > itPlaced->second) {
-            fprintf(stderr, "Section %s will overlap with section %s.\n", curSec.getName().c_str(), itPlaced->first.c_str());
-            return -1;
-          } 
-        }
-      }
+  // Copy kept entries together and point the instructions to the entries' new locations:
+  vector<char> newContent(content.begin(), content.begin() + length);
+  newContent.resize(newSize);
+  for (uint slot = 0; slot < slotCount; slot++) {
+    if (newLocations[slot] != -1) memcpy(newContent.data() + newLocations[slot], content.data() + length + 4 * slot, 4);
+  }
+  for (uint position : sec.getPoolRefs()) {
+    uint instr;
+    memcpy(&instr, newContent.data() + position, sizeof(uint));
+    uint slot = (position + 4 + (instr & maxDisp) - length) / 4;
+
+    uint disp;
+    if (newLocations[slot] != -1) disp = newLocations[slot] - (position + 4);
+    else disp = newSize - (position + 4) + tailSize - mergedWith[slot];
+    instr = (instr & ~maxDisp) | disp;
+    memcpy(newContent.data() + position, &instr, sizeof(uint));
+  }
 
-      // Before placing this section at its address, check for overlap with the previous and next section in the processed set.
-      // Check for overlap with the previous only if there weren't processed section with the same name in the for loop above.
-      //   If there is overlap with the previous, throw an error (previous can only be a section with a -place option).
-      if (itProc != processedSections.rend() && itProc->getBase() + itProc->getContent().size() > address) {
-        if (placedSections.find(itProc->getName()) != placedSections.end()) {
-          cout << "Section " << curSec.getName() << " overlaps with section " << itProc->getName() << " which precedes it." << endl;
-          return -1;
-        }
-        // If we first placed some sections without -place option and then the furthest one with -place, this happens:
-        else {
-          moveSectionsAfterAddress(address, curSec.getContent().size());
-        }
-      }
-      // If there is overlap with the next, check if the initialAddress == maxPlacedAddress.
-      //   If it is, move all the sections in processed set after current for current.content.size(). As well as locCounter. 
-      //   If it isn't, throw an error (because the current sections has reached content of a latter section with a -place option).
-      else if (itProc != processedSections.rbegin()) {
-        itProc--;
-        if (address + curSec.getContent().size() > itProc->getBase()) {
-          if (initialAddress != maxPlacedAddress) {
-            cout << "Section " << curSec.getName() << " overlaps with section " << itProc->getName() << " which starts after it." << endl;
-            return -1;
-          }
-          else {
-            moveSectionsAfterAddress(address, curSec.getContent().size());
-          }
-        }
-      }
-      // This is the furthest -place section and we haven't placed any non -place sections already:
-      if (address + curSec.getContent().size() > locCounter) locCounter += curSec.getContent().size();
+  // Relocations of pool entries move with them, or go away if the entry is merged:
+  vector<pair<uint, uint>> relEntries;
+  for (const pair<uint, uint>& rel : file.relocationTables.getRelTable(sec.getName()).getEntries()) {
+    if (rel.second < length) relEntries.push_back(rel);
+    else if (newLocations[(rel.second - length) / 4] != -1) relEntries.push_back(make_pair(rel.first, newLocations[(rel.second - length) / 4]));
+  }
+  RelocationTable newRelTable;
+  newRelTable.setEntries(std::move(relEntries));
+  file.relocationTables.addOrUpdateTable(sec.getName(), std::move(newRelTable));
+
+  unordered_map<int, uint> poolEntriesLit;
+  for (const pair<const int, uint>& lit : sec.getPoolEntriesLit()) {
+    int newLocation = newLocations[(lit.second - length) / 4];
+    if (newLocation != -1) poolEntriesLit.insert(make_pair(lit.first, newLocation));
+  }
+  unordered_map<uint, uint> poolEntriesSym;
+  for (const pair<const uint, uint>& sym : sec.getPoolEntriesSym()) {
+    int newLocation = newLocations[(sym.second - length) / 4];
+    if (newLocation != -1) poolEntriesSym.insert(make_pair(sym.first, newLocation));
+  }
+  sec.setPoolEntriesLit(std::move(poolEntriesLit));
+  sec.setPoolEntriesSym(std::move(poolEntriesSym));
+  sec.setContent(std::move(newContent));
+}
+
+// Gives every section its base: (processedSections will hold all sections sorted by base)
+//  Groups with a -place option start at their address, all other groups follow the furthest of them in the order
+//  of their first appearance. Sections of a group are put one after another in the order they were read in.
+int layoutSections() {
+  map<uint, uint> laidOutPlaced;  // Address -> sectName, for groups with a -place option that were given their base.
+
+  for (SectionGroup& group : sectionGroups) {
+    unordered_map<uint, uint>::iterator itPlac = placedSections.find(group.name);  // secName -> address
+    if (itPlac == placedSections.end()) continue;
 
-      // Set the base of the current section
-      it->second.setBase(address);
+    uint address = itPlac->second;
+    uint end = address + group.size;
+
+    // Check for overlap with a further -place section:
+    multimap<uint, uint>::iterator itNext = placeAddresses.upper_bound(address);
+    if (itNext != placeAddresses.end() && end > itNext->first) {
+      fprintf(stderr, "Section %s will overlap with section %s.\n", 
+              stringTable.name(group.name).c_str(), stringTable.name(itNext->second).c_str());
+      return -1;
     }
+    // Check for another -place section at the same address:
+    map<uint, uint>::iterator itSame = laidOutPlaced.find(address);
+    if (itSame != laidOutPlaced.end()) {
+      cout << "Section " << stringTable.name(group.name) << " overlaps with section " << stringTable.name(itSame->second) << " which precedes it." << endl;
+      return -1;
+    }
+    laidOutPlaced.insert(make_pair(address, group.name));
 
-    // Add section to processed sections:
-    processedSections.insert(it->second);      
-    //cout << "Processed section:  secName: " << it->second.getName() << ", base: " << it->second.getBase() << ", contentSize: " << it->second.getContent().size() << " bytes." << endl;
+    group.base = address;
+    if (end > locCounter) locCounter = end;
   }
-    
+
+  for (SectionGroup& group : sectionGroups) {
+    if (placedSections.find(group.name) != placedSections.end()) continue;
+
+    group.base = locCounter;
+    locCounter += group.size;
+  }
+
+  processedSections.reserve(processedSections.size() + sectionGroups.size());
+  for (SectionGroup& group : sectionGroups) {
+    uint address = group.base;
+    for (Section& sec : group.sections) {
+      sec.setBase(address);
+      address += sec.getContent().size();
+      processedSections.push_back(std::move(sec));
+    }
+    group.sections.clear();
+  }
+  sort(processedSections.begin(), processedSections.end());
+
   return 0;
 }
 
 
-// Merge contents of successive sections:
+// Merge contents of successive sections: (only sizes them in the binary output file, sections' contents are copied in by relocateSections)
 int joinMemoryContents() {
-  if (finishedSections.size() == 0) {
+  if (processedSections.size() == 0) {
     fprintf(stderr, "Linker has no sections to output.\n");
     return -1;
   }
 
-  uint startingAddress = finishedSections[0].getBase();
-  vector<char> memContent = finishedSections[0].getContent();
+  // Find runs of continuous sections:
+  vector<pair<uint, uint>> runs;  // <startingAddress, size>
+  for (Section& sec : processedSections) {
+    if (runs.empty() || sec.getBase() != runs.back().first + runs.back().second) {
+      runs.push_back(make_pair(sec.getBase(), 0));
+    }
+    runs.back().second += sec.getContent().size();
+  }
+
+  // Sections are written straight into the binary output file if it can be mapped:
+  ulong fileSize = binaryFileHeaderSize + sizeof(uint);
+  for (pair<uint, uint>& run : runs) fileSize += 2 * sizeof(uint) + run.second;
+
+  if (mapOutputFile(fileSize) == 0) {
+    char* p = outputImage;
+    uint header[3] = { executableFileMagic, binaryFileVersion, (uint)runs.size() };
+    memcpy(p, header, sizeof(header));
+    p += sizeof(header);
+    for (pair<uint, uint>& run : runs) {
+      memcpy(p, &run.first, sizeof(uint));
+      memcpy(p + sizeof(uint), &run.second, sizeof(uint));
+      p += 2 * sizeof(uint) + run.second;
+    }
+    viewOutputImage();
+  }
+  else {
+    memoryContents.reserve(runs.size());
+    for (pair<uint, uint>& run : runs) {
+      memoryContents.push_back(MemoryContent(run.first, vector<char>(run.second)));
+    }
+  }
 
-  for (uint i = 1; i < finishedSections.size(); i++) {
-    uint sectionBase = finishedSections[i].getBase();
-    vector<char> sectionContent = finishedSections[i].getContent();
+  // Tell every input file where its sections go:
+  uint iRun = 0;
+  for (Section& sec : processedSections) {
+    if (sec.getBase() >= runs[iRun].first + runs[iRun].second) iRun++;
+    char* destination = memoryContents[iRun].getData() + (sec.getBase() - runs[iRun].first);
+    inputFiles[sec.getAsmFileId()].outputSections.push_back(make_pair(&sec, destination));
+  }
 
-      // Join continuous sections' contents:
-    if (sectionBase == startingAddress + memContent.size()) {
-      uint wi = memContent.size();
+  return 0;
+}
 
-      memContent.resize(memContent.size() + sectionContent.size());
+// Maps the binary output file into memory: (with fileSize 0, the existing file is mapped as it is)
+int mapOutputFile(ulong fileSize) {
+  string prefix = "../tests/";
+  string fileName = prefix + outputFileName;
 
-      for (uint j = 0; j < sectionContent.size(); j++) {
-        memContent[wi++] = sectionContent[j];
-      }
+  outputFd = fileSize ? open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(fileName.c_str(), O_RDWR);
+  if (outputFd == -1) return -1;
+
+  struct stat st;
+  if (fileSize) {
+    if (ftruncate(outputFd, fileSize) == 0) outputImageSize = fileSize;
+  }
+  else if (fstat(outputFd, &st) == 0) outputImageSize = st.st_size;
+
+  if (outputImageSize != 0) {
+    outputImage = (char*)mmap(nullptr, outputImageSize, PROT_READ | PROT_WRITE, MAP_SHARED, outputFd, 0);
+    if (outputImage == MAP_FAILED) outputImage = nullptr;
+  }
+  if (!outputImage) {
+    close(outputFd);
+    outputFd = -1;
+    outputImageSize = 0;
+    return -1;
+  }
+
+  return 0;
+}
+
+// Points memoryContents into the mapped binary output file: (returns -1 if it isn't a linker's output)
+int viewOutputImage() {
+  uint header[3];
+  if (outputImageSize < sizeof(header)) return -1;
+  memcpy(header, outputImage, sizeof(header));
+  if (header[0] != executableFileMagic || header[1] != binaryFileVersion) return -1;
+
+  ulong offset = sizeof(header);
+  memoryContents.reserve(header[2]);
+  for (uint i = 0; i < header[2]; i++) {
+    uint run[2];  // <startAddress, size>
+    if (offset + sizeof(run) > outputImageSize) return -1;
+    memcpy(run, outputImage + offset, sizeof(run));
+    offset += sizeof(run);
+    if (offset + run[1] > outputImageSize) return -1;
+
+    memoryContents.push_back(MemoryContent(run[0], outputImage + offset, run[1]));
+    offset += run[1];
+  }
+
+  return 0;
+}
+
+// Writes the mapped binary output file back and releases it:
+void unmapOutputFile() {
+  if (!outputImage) return;
+
+  munmap(outputImage, outputImageSize);
+  close(outputFd);
+  outputImage = nullptr;
+  outputImageSize = 0;
+  outputFd = -1;
+}
+
+// Copies an input file's sections into memoryContents and writes symbol values in their pools:
+//  (on the locations specified with RelocationTables)
+void relocateSections(InputFile& file) {
+  // Value of every name the file uses, indexed by its id in stringTable: (only the file's own names are up to date)
+  thread_local vector<uint> symbolValues;
+  if (symbolValues.size() < stringTable.size()) symbolValues.resize(stringTable.size());
+
+  for (uint symName : file.fileIds) {
+    SymbolTableEntry* localSymbol = file.symbolTable.lookFor(symName);
+
+    // For local symbol, get its value from section's SymbolTable: 
+    if (localSymbol && localSymbol->getType() != 'e') {
+      symbolValues[symName] = localSymbol->getValue();
     }
+    // For extern symbol, get its value from linker's resulting SymbolTables:
     else {
-      // Create the joined memory content object:
-      MemoryContent mc = MemoryContent(startingAddress, memContent);
-      memoryContents.push_back(mc);
+      SymbolTableEntry* globalSymbol = resSymbolTable.lookFor(symName);
+      symbolValues[symName] = globalSymbol ? globalSymbol->getValue() : 0;
+    }
+  }
 
-      // Start a new joined content:
-      startingAddress = sectionBase;
-      memContent.clear();
-      memContent = sectionContent;
+  // For -incremental, remember which relocations depend on resSymbolTable:
+  thread_local vector<bool> fromResSymbolTable;
+  if (incrementalOption) {
+    if (fromResSymbolTable.size() < stringTable.size()) fromResSymbolTable.resize(stringTable.size());
+    for (uint symName : file.fileIds) {
+      SymbolTableEntry* localSymbol = file.symbolTable.lookFor(symName);
+      fromResSymbolTable[symName] = !(localSymbol && localSymbol->getType() != 'e');
     }
   }
 
-  // Create the last joined content object:
-  MemoryContent mc = MemoryContent(startingAddress, memContent);
-  memoryContents.push_back(mc);
+  for (pair<Section*, char*>& out : file.outputSections) {
+    const vector<char>& content = out.first->getContent();
+    memcpy(out.second, content.data(), content.size());
 
-  return 0;
+    const vector<pair<uint, uint>>& relEntries = file.relocationTables.getRelTable(out.first->getName()).getEntries();
+    for (const pair<uint, uint>& entry : relEntries) {
+      uint value = symbolValues[entry.first];
+
+      // Write bytes of the value in the little endian format:
+      for (int i = 0; i < 4; i++) {
+        out.second[entry.second + i] = (value >> (8*i)) & 0xff;
+      }
+
+      if (incrementalOption && fromResSymbolTable[entry.first]) {
+        file.globalSites.push_back(make_pair(out.first->getBase() + entry.second, entry.first));
+      }
+    }
+  }
 }
 
 
-// Open output file for printing:
-FILE* openOutputFile() {
+/// ---- Incremental linking: ----
+
+// Name of the cache file written next to the output:
+string linkCacheFileName() {
+  return "../tests/" + outputFileName + ".linkcache";
+}
+
+// Reads the previous binary output: (memoryContents)
+int readBinaryFile() {
+  // Patch the output in place if it can be mapped:
+  if (mapOutputFile(0) == 0) {
+    if (viewOutputImage() == 0) return 0;
+    memoryContents.clear();
+    unmapOutputFile();
+    return -1;
+  }
+
   string prefix = "../tests/";
-  string fileName = prefix + outputFileName;
-  fileName += ".txt";
+  ifstream in(prefix + outputFileName, ios::binary);
+  if (in.fail() || bReadUint(in) != executableFileMagic || bReadUint(in) != binaryFileVersion) return -1;
 
-  FILE* outputFile = fopen(fileName.c_str(), "w");
-  if (!outputFile) {
-    fprintf(stderr, "Error: Couldn't open the requested outputFile.\n");
+  uint memContentsCount = bReadUint(in);
+  for (uint i = 0; i < memContentsCount && !in.fail(); i++) {
+    memoryContents.push_back(MemoryContent());
+    memoryContents.back().bRead(in);
   }
+  if (in.fail()) return -1;
 
-  return outputFile;
+  return 0;
+}
+
+// Where the byte at the given address is in memoryContents: (nullptr if it's not in any of them)
+char* outputLocation(uint address, uint size) {
+  int lo = 0, hi = (int)memoryContents.size() - 1, found = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (memoryContents[mid].getStartAddress() <= address) {
+      found = mid;
+      lo = mid + 1;
+    }
+    else hi = mid - 1;
+  }
+  if (found == -1) return nullptr;
+
+  MemoryContent& mc = memoryContents[found];
+  if ((ulong)address + size > (ulong)mc.getStartAddress() + mc.getSize()) return nullptr;
+  return mc.getData() + (address - mc.getStartAddress());
+}
+
+// Global symbols an input file defines: (with their values after its sections were placed)
+vector<pair<uint, uint>> definedGlobals(InputFile& file) {
+  vector<pair<uint, uint>> globals;
+  for (const pair<const uint, SymbolTableEntry>& sym : file.symbolTable.getSymbols()) {
+    if (sym.second.type == 'g') globals.push_back(make_pair(sym.first, sym.second.value));
+  }
+  sort(globals.begin(), globals.end());
+  return globals;
 }
 
-// Writes txt file in the specified format:
-void hexPrint(FILE* outputFile) {
-  uint addressCount = 0;
-  uint stPos = 0;  // Indicates on what byte in line did we stop printing the previous section
-
-  for (vector<Section>::iterator it = finishedSections.begin(); it != finishedSections.end(); it++) {
-    // If the content of the next section should start in the same line where the previous section's ended:
-    if (it->getBase() < addressCount + 8 && stPos != 0) {
-      int byteInLine = it->getBase() % 8;
-      // Print '--' for the unused bytes in the line between the end of the previous and the start of the next section:
-      while (stPos < byteInLine) {
-        fprintf(outputFile, "-- ");
-        stPos++;
+// Relinks only the input files that changed since the last link with '-incremental':
+//  Returns 0 if the outputs were updated, -1 on a link error, and 1 if a full link is needed.
+int relinkIncrementally() {
+  // Archive members aren't tracked by the cache, with '--gc-sections' a change can make other files' sections reachable
+  //  and with '--dedup-pools' it can change which pool entries of other files are merged:
+  if (!archiveFileNames.empty() || gcSectionsOption || dedupPoolsOption) return 1;
+
+  /// Load the cache and make sure it's from a link with the same arguments:
+  ifstream in(linkCacheFileName(), ios::binary);
+  if (in.fail() || linkCache.bRead(in) == -1) return 1;
+  in.close();
+
+  if (linkCache.files.size() != inputFileNames.size()) return 1;
+  for (uint i = 0; i < inputFileNames.size(); i++) {
+    if (linkCache.files[i].fileName != inputFileNames[i]) return 1;
+  }
+
+  vector<pair<uint, uint>> placeOptions;
+  for (multimap<uint, uint>::iterator it = placeAddresses.begin(); it != placeAddresses.end(); it++) {
+    placeOptions.push_back(make_pair(it->second, it->first));
+  }
+  if (placeOptions != linkCache.placeOptions) return 1;
+
+  ulong outputHash;
+  if (hashFile("../tests/" + outputFileName, outputHash) == -1 || outputHash != linkCache.outputHash) return 1;
+  if (readBinaryFile() == -1) return 1;
+
+
+  /// Find input files that changed and read only them:
+  bool anyChanged = false;
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (hashFile("../tests/" + inputFiles[i].fileName, inputFiles[i].hash) == -1) return 1;
+    inputFiles[i].cached = inputFiles[i].hash == linkCache.files[i].hash;
+    if (!inputFiles[i].cached) anyChanged = true;
+  }
+  if (!anyChanged) {
+    resSymbolTable = std::move(linkCache.resSymbolTable);  // For the '-Map' file.
+    return 0;
+  }
+
+  if (readAssemblerFiles() == -1) return -1;
+
+  // The layout stays the same only if changed files have the same sections with the same sizes:
+  uint sectionCount = 0;
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (inputFiles[i].cached) continue;
+
+    const vector<LinkCacheSection>& cachedSections = linkCache.files[i].sections;
+    uint count = 0;
+    for (uint sectName : inputFiles[i].sectionTable.getSectionOrder()) {
+      uint size = inputFiles[i].sectionTable.lookFor(sectName)->getContent().size();
+      if (size == 0) continue;
+
+      bool found = false;
+      for (const LinkCacheSection& s : cachedSections) {
+        if (s.name == sectName && s.size == size) found = true;
       }
+      if (!found) return 1;
+      count++;
     }
-    // Otherwise, skip to the 8byte including the starting byte of the next section:
-    else {
-      if (stPos != 0) fprintf(outputFile, "\n");
-      stPos = 0;  // this is necessary!
-
-      int byteInLine = it->getBase() % 8;
-      addressCount += (it->getBase() - byteInLine) - addressCount;
-
-      // If byteInLine == 0, in the for loop below the address and the line will be printed normally.
-      if (byteInLine != 0) {  
-        ostringstream ss;
-        ss << uppercase << setfill('0') << std::setw(4)<< hex << addressCount;
-        string address = ss.str() + ": ";
-        fprintf(outputFile, "%s", address.c_str());
-
-        // Print '--' for the unused bytes at the start of the 8byte address until the beggining of the section:
-        while (stPos < byteInLine) {
-          fprintf(outputFile, "-- ");
-          stPos++;
-        }
+    if (count != cachedSections.size()) return 1;
+    sectionCount += count;
+  }
+
+  // Changed files' sections go where they were: (and their local symbols' values follow)
+  processedSections.reserve(sectionCount);
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (inputFiles[i].cached) continue;
+
+    for (const LinkCacheSection& s : linkCache.files[i].sections) {
+      Section* sec = inputFiles[i].sectionTable.lookFor(s.name);
+      sec->setBase(s.base);
+      sec->setAsmFileId(i);
+      inputFiles[i].symbolTable.updateLocalSymbolsValuesForSection(s.name, s.base);
+
+      processedSections.push_back(std::move(*sec));
+      char* destination = outputLocation(s.base, s.size);
+      if (destination == nullptr) return 1;
+      inputFiles[i].outputSections.push_back(make_pair(&processedSections.back(), destination));
+    }
+  }
+
+  // ... and they must define the same global symbols:
+  resSymbolTable = std::move(linkCache.resSymbolTable);
+  unordered_set<uint> changedGlobals;
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (inputFiles[i].cached) continue;
+
+    vector<pair<uint, uint>> globals = definedGlobals(inputFiles[i]);
+    const vector<pair<uint, uint>>& cachedGlobals = linkCache.files[i].globals;
+    if (globals.size() != cachedGlobals.size()) return 1;
+    for (uint g = 0; g < globals.size(); g++) {
+      if (globals[g].first != cachedGlobals[g].first) return 1;
+      if (globals[g].second != cachedGlobals[g].second) {
+        resSymbolTable.lookFor(globals[g].first)->setValue(globals[g].second);
+        changedGlobals.insert(globals[g].first);
       }
     }
+  }
+
 
+  /// Relink the changed files:
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (inputFiles[i].cached || inputFiles[i].outputSections.empty()) continue;
+    if (inputFiles[i].symbolTable.checkForUndefinedExtern(resSymbolTable) == -1) return -1;
+  }
+  forEachInputFile(relocateSections);
+
+  // Unchanged files only need the relocations of global symbols whose value changed:
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    if (!inputFiles[i].cached) continue;
 
-    // Print the content of the section:
-    vector<char> sectionContent = it->getContent();
+    for (pair<uint, uint>& site : linkCache.files[i].globalSites) {
+      if (changedGlobals.find(site.second) == changedGlobals.end()) continue;
 
-    for (uint i = 0; i < sectionContent.size(); i++) {
-      if (stPos == 0) {
-        ostringstream ss;
-        ss << uppercase << setfill('0') << std::setw(4) << hex << addressCount;
-        string address = ss.str() + ": ";
-        fprintf(outputFile, "%s", address.c_str());
+      uint value = resSymbolTable.lookFor(site.second)->getValue();
+      char* location = outputLocation(site.first, 4);
+      for (int b = 0; b < 4; b++) {
+        location[b] = (value >> (8*b)) & 0xff;
       }
+    }
+  }
+
 
-      char byte = sectionContent[i];
-      int hex1 = ((byte >> 4) & 0xf);
-      int hex2 = (byte & 0xf); 
+  /// Write the outputs:
+  writeTxtFile();
+  writeBinaryFile();
+  return writeLinkCache();
+}
 
-      fprintf(outputFile, "%X%X ", hex1, hex2); // Todo: check.
-      stPos += 1;
+// Writes the cache for the next '-incremental' link:
+int writeLinkCache() {
+  linkCache.placeOptions.clear();
+  for (multimap<uint, uint>::iterator it = placeAddresses.begin(); it != placeAddresses.end(); it++) {
+    linkCache.placeOptions.push_back(make_pair(it->second, it->first));
+  }
 
-      if (stPos % 8 == 0) {
-        stPos = 0;
-        addressCount += 8;
-        fprintf(outputFile, "\n");
-      }
+  linkCache.files.resize(inputFiles.size());
+  for (uint i = 0; i < inputFiles.size(); i++) {
+    InputFile& file = inputFiles[i];
+    if (file.cached) continue;
+
+    LinkCacheFile& cf = linkCache.files[i];
+    cf.fileName = file.fileName;
+    if (file.hash == 0 && hashFile("../tests/" + file.fileName, file.hash) == -1) return -1;
+    cf.hash = file.hash;
+
+    cf.sections.clear();
+    for (pair<Section*, char*>& out : file.outputSections) {
+      cf.sections.push_back({ out.first->getName(), out.first->getBase(), (uint)out.first->getContent().size() });
     }
+    cf.globals = definedGlobals(file);
+    cf.globalSites = std::move(file.globalSites);
   }
+
+  linkCache.resSymbolTable = resSymbolTable;
+  if (hashFile("../tests/" + outputFileName, linkCache.outputHash) == -1) return -1;
+
+  ofstream out(linkCacheFileName(), ios::binary);
+  if (out.fail()) {
+    fprintf(stderr, "Linker Error: couldn't write the link cache in the 'tests' directory.\n");
+    return -1;
+  }
+  linkCache.bWrite(out);
+  out.close();
+
+  return 0;
+}
+
+
+// Open output file for printing:
+FILE* openOutputFile() {
+  string prefix = "../tests/";
+  string fileName = prefix + outputFileName;
+  fileName += ".txt";
+
+  FILE* outputFile = fopen(fileName.c_str(), "w");
+  if (!outputFile) {
+    fprintf(stderr, "Error: Couldn't open the requested outputFile.\n");
+  }
+
+  return outputFile;
 }
 
 // Write txt file:
@@ -374,7 +1010,7 @@ int writeTxtFile() {
     return -1;
   }
 
-  hexPrint(outputFile);
+  hexWrite(outputFile, memoryContents);
 
   fclose(outputFile);
 
@@ -383,13 +1019,20 @@ int writeTxtFile() {
 
 // Write binary file:
 int writeBinaryFile() {
+  // Sections were written straight into the mapped file:
+  if (outputImage) {
+    unmapOutputFile();
+    return 0;
+  }
+
   string prefix = "../tests/";
-  ofstream out(prefix + outputFileName); 
+  ofstream out(prefix + outputFileName, ios::binary); 
   if (out.fail()) {
     fprintf(stderr, "Linker Error: couldn't write a binary output file in the 'tests' directory.\n");
     return -1;
   } 
 
+  bWriteHeader(out, executableFileMagic);
   uint memContentsCount = memoryContents.size();
   out.write((char*)&memContentsCount, sizeof(uint));
 
@@ -404,91 +1047,191 @@ int writeBinaryFile() {
 
 
 
+/// ---- Link map: ----
+
+void endPhase(const char* name) {
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  phaseTimes.push_back(make_pair(string(name), chrono::duration<double, milli>(now - phaseStart).count()));
+  phaseStart = now;
+}
+
+
+vector<MapSection> mapSections(bool fromLinkCache) {
+  vector<MapSection> sections;
+
+  if (fromLinkCache) {
+    for (LinkCacheFile& cf : linkCache.files) {
+      for (LinkCacheSection& sec : cf.sections) {
+        sections.push_back({ sec.base, sec.size, sec.name, cf.fileName });
+      }
+    }
+    sort(sections.begin(), sections.end(), [](const MapSection& a, const MapSection& b) { return a.base < b.base; });
+  }
+  else {
+    for (vector<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
+      sections.push_back({ itProc->getBase(), (uint)itProc->getContent().size(), itProc->getName(), inputFiles[itProc->getAsmFileId()].fileName });
+    }
+  }
+
+  return sections;
+}
+
+
+int writeMapFile(bool fromLinkCache) {
+  string fileName = "../tests/" + mapFileName;
+  FILE* mapFile = fopen(fileName.c_str(), "w");
+  if (!mapFile) {
+    fprintf(stderr, "Error: Couldn't open the requested map file.\n");
+    return -1;
+  }
+
+  fprintf(mapFile, "Link map of %s\n\n", outputFileName.c_str());
+
+  // Sections:
+  fprintf(mapFile, "Sections:\n");
+  fprintf(mapFile, "  %-10s %-10s %-20s %s\n", "Base", "Size", "Section", "Object");
+  for (MapSection& sec : mapSections(fromLinkCache)) {
+    fprintf(mapFile, "  %08X   %08X   %-20s %s\n", sec.base, sec.size, stringTable.name(sec.name).c_str(), sec.fileName.c_str());
+  }
+
+  // Global symbols, sorted by address:
+  vector<pair<uint, uint>> symbols;  // <value, symName>
+  for (const pair<const uint, SymbolTableEntry>& sym : resSymbolTable.getSymbols()) {
+    if (sym.second.type == 'g') symbols.push_back(make_pair(sym.second.value, sym.first));
+  }
+  sort(symbols.begin(), symbols.end(), [](const pair<uint, uint>& a, const pair<uint, uint>& b) {
+    return a.first != b.first ? a.first < b.first : stringTable.name(a.second) < stringTable.name(b.second);
+  });
+
+  fprintf(mapFile, "\nSymbols:\n");
+  fprintf(mapFile, "  %-10s %-20s %s\n", "Address", "Symbol", "Section");
+  for (pair<uint, uint>& sym : symbols) {
+    const SymbolTableEntry& entry = resSymbolTable.getSymbols().at(sym.second);
+    fprintf(mapFile, "  %08X   %-20s %s\n", sym.first, stringTable.name(sym.second).c_str(), stringTable.name(entry.section).c_str());
+  }
+
+  // Phase timings and peak memory use:
+  fprintf(mapFile, "\nTimings:\n");
+  for (pair<string, double>& phase : phaseTimes) {
+    fprintf(mapFile, "  %-20s %10.3f ms\n", phase.first.c_str(), phase.second);
+  }
+  fprintf(mapFile, "  %-20s %10.3f ms\n", "total", chrono::duration<double, milli>(chrono::steady_clock::now() - linkStart).count());
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  fprintf(mapFile, "\nPeak RSS: %ld KB\n", usage.ru_maxrss);  // Linux reports it in kilobytes.
+
+  fclose(mapFile);
+  return 0;
+}
+
+
+
 
 int main(int argc, char* argv[]) {
   /// Process command line arguments:
   if (processCommandLineArguments(argc, argv) == -1) return -1;
   locCounter = maxPlacedAddress;
+  linkStart = phaseStart = chrono::steady_clock::now();
+
+  initInputFiles();
+
+  /// Try relinking only the input files that changed:
+  if (incrementalOption) {
+    int res = relinkIncrementally();
+    if (res == 0 && mapFileName != "") {
+      endPhase("incremental relink");
+      return writeMapFile(true);
+    }
+    if (res != 1) return res;
+
+    // Otherwise, fall back to a full link:
+    memoryContents.clear();
+    unmapOutputFile();
+    processedSections.clear();
+    resSymbolTable = SymbolTable();
+    linkCache = LinkCache();
+    initInputFiles();
+    endPhase("incremental check");
+  }
+
+  /// Reading assembler's binary outputs:
+  if (readAssemblerFiles() == -1) return -1;
+
+  /// Add archive members that are needed:
+  if (readArchives() == -1) return -1;
+  if (extractArchiveMembers() == -1) return -1;
 
+  /// Drop sections that aren't used:
+  if (gcSectionsOption && collectGarbageSections() == -1) return -1;
+  endPhase("read");
 
-  for (int i = 0; i < inputFileNames.size(); i++) {
-    /// Reading assembler's binary outputs:
-    if (readAssemblerFile(inputFileNames[i]) == -1) return -1;
+  for (int i = 0; i < inputFiles.size(); i++) {
+    curSectionTable = std::move(inputFiles[i].sectionTable);
 
     // Remember to which SymbolTable and RelocationTable the sections belong to before you start sorting them all together:
     curSectionTable.setSectionsAsmFileId(i);
-    // Save this asm's file SymbolTable and RelocationTable for later use:
-    asmSymbolTables.push_back(curSymbolTable);
-    asmRelTables.push_back(curRelocationTables);
 
-    // Place assembler's sections in the resulting sections order: (in the processedSections multiset)
+    // Group assembler's sections with the same-named sections from previous files:
     if (placeSection() == -1) return -1;
   }
 
+  // Merge identical pool entries of sections that end up next to each other:
+  if (dedupPoolsOption) dedupPools();
 
-  // Print final order of sections for debugging:
-  // cout << endl << "-----------------" << endl;
-  // cout << "Printing final order of sections:" << endl;
-  // for (multiset<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
-  //   fprintf(stdout, "SecName: %s, base: %X, contentSize: %ld bytes\n", itProc->getName().c_str(), itProc->getBase(), itProc->getContent().size());
-  // }
+  // Place all sections in the resulting sections order: (in the processedSections vector)
+  if (layoutSections() == -1) return -1;
+  endPhase("placement");
 
 
-
-  for (multiset<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
+  for (vector<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
     // Put section's names into the resulting SymbolTable: (only the first occurance of the section name and it's base)
     resSymbolTable.createSymbolEntry(itProc->getName(), itProc->getName(), itProc->getBase(), 'l');   // Will not overwrite existing entry with the same name.
 
     // Increase local symbols' values in intern SymbolTable for section's base value: 
-    asmSymbolTables[itProc->getAsmFileId()].updateLocalSymbolsValuesForSection(itProc->getName(), itProc->getBase());
+    inputFiles[itProc->getAsmFileId()].symbolTable.updateLocalSymbolsValuesForSection(itProc->getName(), itProc->getBase());
   }
 
   // Put all global syms from the intern SymbolTable into the resulting SymbolTable: (while checking for multiple definitions error)
-  for (int i = 0; i < asmSymbolTables.size(); i++) {
-    if (asmSymbolTables[i].exportGlobalSymbols(resSymbolTable) == -1) { // Passing resSymbolTable by reference.
+  for (int i = 0; i < inputFiles.size(); i++) {
+    if (inputFiles[i].symbolTable.exportGlobalSymbols(resSymbolTable) == -1) { // Passing resSymbolTable by reference.
       return -1;  
     }
   }
 
 
 
-  for (multiset<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
+  // Check for usage of extern non-defined symbols: (once for every file that has sections in the output)
+  vector<bool> checkedFiles(inputFiles.size(), false);
+  for (vector<Section>::iterator itProc = processedSections.begin(); itProc != processedSections.end(); itProc++) {
     int asmId = itProc->getAsmFileId();
+    if (checkedFiles[asmId]) continue;
+    checkedFiles[asmId] = true;
 
-    // Check for usage of extern non-defined symbols:
-    if (asmSymbolTables[asmId].checkForUndefinedExtern(resSymbolTable) == -1) {
+    if (inputFiles[asmId].symbolTable.checkForUndefinedExtern(resSymbolTable) == -1) {
       return -1;
     }
-
-    // Write symbol values in the section's pool: (on the locations specified with RelocationTables)
-    Section s = *itProc;
-
-    RelocationTable sectRelocationTable = asmRelTables[asmId].getRelTable(itProc->getName());
-    if (sectRelocationTable.getEntries().size() != 0) {
-      s.writeRelocations(sectRelocationTable, &asmSymbolTables[asmId], resSymbolTable);
-    }
-
-    finishedSections.push_back(s);
   }
+  endPhase("symbol export");
 
-
-  // cout << endl << "Resulting SymbolTable: " << endl;
-  // resSymbolTable.printSymbolTable(stdout);
-  // cout << "----------------" << endl;
-
-  // cout << "Finished sections after linker: " << endl;
-  // for (vector<Section>::iterator i = finishedSections.begin(); i != finishedSections.end(); i++) {
-  //   i->printSection(stdout);
-  // }
+  /// Create joined memory contents for binary output, and copy relocated sections into them:
+  if (joinMemoryContents() == -1) return -1;
+  forEachInputFile(relocateSections);
+  endPhase("relocation");
 
   /// Open and write the txt output file:
   writeTxtFile();
-
-  /// Create joined memory contents for binary output:
-  if (joinMemoryContents() == -1) return -1;
+  endPhase("hex write");
 
   // Write binary output:
   writeBinaryFile();
+  endPhase("binary write");
+
+  // Write the cache for the next incremental link:
+  if (incrementalOption && archiveFileNames.empty() && !gcSectionsOption && !dedupPoolsOption && writeLinkCache() == -1) return -1;
+
+  // Write the link map:
+  if (mapFileName != "" && writeMapFile(false) == -1) return -1;
 
 
 	return 0;
@@ -1,15 +1,50 @@
 #include "../inc/parserHelper.hpp"
 #include <stdlib.h>
 #include <stdio.h>
+#include <vector>
 // #include <string.h>
 
 
-command *commandsHead = NULL, *commandsCur = commandsHead;
+// FNV-1a:
+static size_t hashIdentifier(const char* text, size_t len) {
+  size_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)text[i]) * 16777619u;
+  return h;
+}
+
+char* ParserState::internIdentifier(const char* text, size_t len) {
+  size_t mask = identifiers.size() - 1;
+  size_t slot = hashIdentifier(text, len) & mask;
+
+  while (identifiers[slot]) {
+    if (strncmp(identifiers[slot], text, len) == 0 && identifiers[slot][len] == '\0') return identifiers[slot];
+    slot = (slot + 1) & mask;
+  }
 
+  char* identifier = identifierArena.copyString(text, len);
+  identifiers[slot] = identifier;
 
-arg* createArg(char* reg, char* sym, int lit, int type)
+  // Grow the table when it gets half full:
+  if (++identifierCount * 2 > identifiers.size()) {
+    std::vector<char*> old(2 * identifiers.size(), nullptr);
+    old.swap(identifiers);
+    mask = identifiers.size() - 1;
+
+    for (char* id : old) {
+      if (!id) continue;
+      size_t s = hashIdentifier(id, strlen(id)) & mask;
+      while (identifiers[s]) s = (s + 1) & mask;
+      identifiers[s] = id;
+    }
+  }
+
+  return identifier;
+}
+
+
+arg* ParserState::createArg(char* reg, char* sym, int lit, int type)
 {
-	arg* a = (arg*)malloc(sizeof(arg));
+	arg* a = arena.create<arg>();
 	a->reg = reg;
   a->sym = sym;
   a->lit = lit;
@@ -18,15 +53,33 @@ arg* createArg(char* reg, char* sym, int lit, int type)
 	return a;
 }
 
-command* createCommand(char *name, arg* args, bool isDirective, lab* labs)
+lab* ParserState::createLab(char* name)
+{
+  lab* l = arena.create<lab>();
+  l->name = name;
+  l->next = NULL;
+  return l;
+}
+
+int ParserState::createCommand(char *name, arg* args, bool isDirective, lab* labs)
 {
-	command* cmnd = (command*)malloc(sizeof(command));
+	command* cmnd = arena.create<command>();
 	cmnd->name = name;
 	cmnd->args = args;
 	cmnd->next = NULL;
   cmnd->isDirective = isDirective;
   cmnd->labs = labs;
 
+  // Look the name up once, both assembler's cycles switch on the mnemonic:
+  cmnd->info = lookupMnemonic(name, isDirective);
+  cmnd->mnemonic = cmnd->info ? cmnd->info->mnemonic : MN_UNKNOWN;
+
+  if (commandHandler) {
+    int res = commandHandler(cmnd);
+    arena.reset();  // Its labels and args are done with as well.
+    return res;
+  }
+
   if (!commandsHead) {
     commandsHead = cmnd;
     commandsCur = commandsHead;
@@ -36,7 +89,7 @@ command* createCommand(char *name, arg* args, bool isDirective, lab* labs)
     commandsCur = commandsCur->next;
   }
 
-	return cmnd;
+	return 0;
 }
 
 
@@ -111,34 +164,3 @@ void printCommands(command* cmndsHead) {
     cmnd = cmnd->next;
   }
 }
-
-
-void freeLabs(lab* labsHead) {
-  while(labsHead) {
-      lab* tmp = labsHead;
-      labsHead = labsHead->next;
-      free(tmp->name);
-      free(tmp);
-  }
-}
-
-void freeArgs(arg* args) {
-  while (args) {
-    arg* tmp = args;
-    args = args->next;
-    free(tmp->reg);
-    free(tmp->sym);
-    free(tmp);
-  }
-}
-
-void freeCommands(command* cmndsHead) {
-  while (cmndsHead) {
-    command* tmp = cmndsHead;
-    cmndsHead = cmndsHead->next;
-    freeLabs(tmp->labs);
-	  free(tmp->name); 
-    freeArgs(tmp->args);
-    free(tmp);
-  }
-}
\ No newline at end of file
@@ -2,8 +2,8 @@
 
 
 // Checks if the entry already exists (both the symbol and location must match)
-void RelocationTable::addEntry(string symName, uint offsetInSection) { 
-  pair<string, uint> pair = make_pair(symName, offsetInSection);
+void RelocationTable::addEntry(uint symName, uint offsetInSection) { 
+  pair<uint, uint> pair = make_pair(symName, offsetInSection);
 
   if (find(entries.begin(), entries.end(), pair) != entries.end()) return;
   entries.push_back(pair); 
@@ -11,11 +11,11 @@ void RelocationTable::addEntry(string symName, uint offsetInSection) {
 
 
 // Printing:
-void RelocationTable::printEntries(FILE* outputFile) {
+void RelocationTable::printEntries(FILE* outputFile, const StringTable& names) {
   if (entries.size() > 0) {
     fprintf(outputFile, "|      Symbol      |     Location     |\n");
     for (uint i = 0; i < entries.size(); i++) {
-      fprintf(outputFile, "%-20s %-20d\n", entries[i].first.c_str(), entries[i].second);
+      fprintf(outputFile, "%-20s %-20d\n", names.name(entries[i].first).c_str(), entries[i].second);
     }
   }
 }
@@ -23,34 +23,20 @@ void RelocationTable::printEntries(FILE* outputFile) {
 
 // Binary file support:
 void RelocationTable::bWrite(std::ofstream& file) {
-  uint len = entries.size();
-  file.write((char*)&len, sizeof(uint));
+  bWriteUint(file, entries.size());
 
-  for (pair<string, uint> p : entries) {
-    len = p.first.length();
-    file.write((char*)&len, sizeof(uint));
-    file.write((char*)p.first.c_str(), len);
-
-    file.write((char*)&p.second, sizeof(uint));
+  for (pair<uint, uint>& p : entries) {
+    bWriteUint(file, p.first);
+    bWriteUint(file, p.second);
   }
 }
-void RelocationTable::bRead(std::ifstream& file) {
-  uint len;
-  file.read((char*)&len, sizeof(uint));
+void RelocationTable::bRead(std::ifstream& file, const vector<uint>& fileIds) {
+  uint len = bReadUint(file);
+  if (file.fail()) return;
   entries.resize(len);
 
-  string key; uint value, keyLen;
-  for (int i = 0; i < len; i++) {
-    file.read((char*)&keyLen, sizeof(uint));
-
-    char* tmp = new char[keyLen+1];
-    tmp[keyLen] = '\0';
-    file.read((char*)tmp, keyLen);
-    key = tmp;
-    delete tmp;
-
-    file.read((char*)&value, sizeof(uint));
-
-    entries[i] = make_pair(key, value);
+  for (uint i = 0; i < len; i++) {
+    entries[i].first = bReadId(file, fileIds);
+    entries[i].second = bReadUint(file);
   }
 }
\ No newline at end of file
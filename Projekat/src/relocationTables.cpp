@@ -2,24 +2,24 @@
 
 
 // Will create a new map key if it doesn't find an existing one.        
-void RelocationTables::addOrUpdateTable(string sectName, RelocationTable& relTable) {
+void RelocationTables::addOrUpdateTable(uint sectName, RelocationTable relTable) {
   // If adding, add to chronological order:
   if (relocationTables.find(sectName) == relocationTables.end()) {
     sectionOrder.push_back(sectName);
   }
 
   // Add or update:
-  relocationTables[sectName] = relTable;
+  relocationTables[sectName] = std::move(relTable);
 }
 
 
 // Printing:
-void RelocationTables::printRelocationTables(FILE* outputFile) {
-  for (string sectName : sectionOrder) {
-    unordered_map<string, RelocationTable>::iterator it = relocationTables.find(sectName);
+void RelocationTables::printRelocationTables(FILE* outputFile, const StringTable& names) {
+  for (uint sectName : sectionOrder) {
+    unordered_map<uint, RelocationTable>::iterator it = relocationTables.find(sectName);
     if (it->second.getEntries().size() != 0) {
-      fprintf(outputFile, "#relo.%s: \n", it->first.c_str());  
-      it->second.printEntries(outputFile);
+      fprintf(outputFile, "#relo.%s: \n", names.name(it->first).c_str());  
+      it->second.printEntries(outputFile, names);
       fprintf(outputFile, "\n"); 
     }
   }
@@ -28,36 +28,23 @@ void RelocationTables::printRelocationTables(FILE* outputFile) {
 
 // Binary file support:
 void RelocationTables::bWrite(std::ofstream& file) {
-  uint len = relocationTables.size();
-  file.write((char*)&len, sizeof(uint));
+  bWriteUint(file, relocationTables.size());
 
-  for (string sectName : sectionOrder) {
-    pair<string, RelocationTable> p = *relocationTables.find(sectName);
-
-    len = p.first.length();
-    file.write((char*)&len, sizeof(uint));
-    file.write((char*)p.first.c_str(), len);
-
-    p.second.bWrite(file);
+  for (uint sectName : sectionOrder) {
+    bWriteUint(file, sectName);
+    relocationTables.find(sectName)->second.bWrite(file);
   }
 }
-void RelocationTables::bRead(std::ifstream& file) {
-  uint len;
-  file.read((char*)&len, sizeof(uint));
+void RelocationTables::bRead(std::ifstream& file, const vector<uint>& fileIds) {
+  uint len = bReadUint(file);
   relocationTables.clear();
+  if (file.fail()) return;
 
-  string key; uint keyLen;
   for (uint i = 0; i < len; i++) {
-    file.read((char*)&keyLen, sizeof(uint));
-
-    char* tmp = new char[keyLen+1];
-    tmp[keyLen] = '\0';
-    file.read((char*)tmp, keyLen);
-    key = tmp;
-    delete tmp;
+    uint key = bReadId(file, fileIds);
 
     RelocationTable rt = RelocationTable();
-    rt.bRead(file);
+    rt.bRead(file, fileIds);
 
     relocationTables.insert(make_pair(key, rt));
     sectionOrder.push_back(key);
@@ -69,10 +56,13 @@ void RelocationTables::bRead(std::ifstream& file) {
 /// ---- For Linker: ----
 
 // Get a section's RelocationTable:
-RelocationTable RelocationTables::getRelTable(string sectName) {
-  if (relocationTables.find(sectName) == relocationTables.end()) {
+const RelocationTable& RelocationTables::getRelTable(uint sectName) const {
+  static const RelocationTable emptyTable;
+
+  unordered_map<uint, RelocationTable>::const_iterator it = relocationTables.find(sectName);
+  if (it == relocationTables.end()) {
     fprintf(stderr, "Tried to access relocation table from RelocationTables which doesn't exist.\n");
-    return RelocationTable();
+    return emptyTable;
   }
-  return relocationTables.find(sectName)->second;
+  return it->second;
 }
\ No newline at end of file
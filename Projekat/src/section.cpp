@@ -4,19 +4,19 @@
 // Only adds a lit/sym to literalTable if it's not already there.
 void Section::addPoolEntry(int value) {
   if (poolEntriesLit.find(value) == poolEntriesLit.end()) {
-    poolEntriesLit.insert(std::make_pair(value, -1)); // Location to be decided after the first assembler cycle.
+    poolEntriesLit.insert(std::make_pair(value, orderId)); // Location to be decided after the first assembler cycle, until then its index in the pool.
     orderOfLits.push_back(make_pair(orderId++,value));
   } 
 }
-void Section::addPoolEntry(std::string symbol) {
+void Section::addPoolEntrySym(uint symbol) {
   if (poolEntriesSym.find(symbol) == poolEntriesSym.end()) {
-    poolEntriesSym.insert(std::make_pair(symbol, -1)); // Location to be decided after the first assembler cycle.
+    poolEntriesSym.insert(std::make_pair(symbol, orderId)); // Location to be decided after the first assembler cycle, until then its index in the pool.
     orderOfSyms.push_back(make_pair(orderId++,symbol));
   } 
 }
 
 uint Section::getPoolEntryLocation(int key) { return poolEntriesLit.find(key)->second; }
-uint Section::getPoolEntryLocation(string key) { return poolEntriesSym.find(key)->second; }
+uint Section::getPoolEntrySymLocation(uint key) { return poolEntriesSym.find(key)->second; }
 
 
 // Fill literalTables with values (locations of lits/syms) after first cycle (that's when the lenght of machine code is known)
@@ -40,7 +40,8 @@ void Section::finalizeLiteralsTable() {
   }
 
   // At this moment, id is the number of bytes needed for this section's machine instructions and pool. 
-  content = vector<char>(id, 0);
+  //  (in a single pass assembly the machine instructions are already written, they are kept)
+  content.resize(id, 0);
 
   // Initialize pool with literal values because we know them already:
   for (std::unordered_map<int, uint>::iterator it = this->poolEntriesLit.begin(); it != this->poolEntriesLit.end(); it++) {
@@ -49,9 +50,16 @@ void Section::finalizeLiteralsTable() {
 }
 
 
+// Single pass assembly writes the content before the section's length is known, so it grows as needed:
+//  (doubling, finalizeLiteralsTable trims it to the final size)
+void Section::growContent(uint size) {
+  content.resize(max((size_t)size, 2 * content.size()), 0);
+}
+
 // Add int to the section's content: (position is given in bytes)
 void Section::addContent(uint position, int item) {
   if (item == 0) return;
+  if (position + 4 > content.size()) growContent(position + 4);
 
   // Write bytes of the given int into content in the little endian format:
   for (int i = 0; i < 4; i++) {
@@ -59,36 +67,34 @@ void Section::addContent(uint position, int item) {
     content[position + i] = byte;
   }
 }
-void Section::addContentInstruction(uint position, string machineInstr) {
-  int rdId = 6, hex1, hex2;
+void Section::addContentInstruction(uint position, uint machineInstr) {
+  if (position + 4 > content.size()) growContent(position + 4);
 
   // Write bytes of the given machineInstr into content in the little endian format:
   for (int i = 0; i < 4; i++) {
-    if (machineInstr[rdId] >= 'A') hex1 = machineInstr[rdId] - 'A' + 10;
-    else hex1 = machineInstr[rdId] - '0';
-    if (machineInstr[rdId+1] >= 'A') hex2 = machineInstr[rdId+1] - 'A' + 10;
-    else hex2 = machineInstr[rdId+1] - '0';
-
-    char byte = ((hex1 << 4) | hex2);
-
-    content[position + i] = byte;
-    rdId -= 2;
+    content[position + i] = (machineInstr >> (8*i)) & 0xff;
   }
 }
 
+void Section::setInstructionDisp(uint position, uint disp) {
+  // Displacement is the lowest 12 bits of the little endian machineInstr:
+  content[position] = disp & 0xff;
+  content[position + 1] = (content[position + 1] & 0xf0) | ((disp >> 8) & 0xf);
+}
+
 
 void Section::printPoolEntries(){
   std::unordered_map<int, uint>::iterator itLit;
-  std::unordered_map<std::string, uint>::iterator itSym;
+  std::unordered_map<uint, uint>::iterator itSym;
 
-  cout << endl << "Pool entries for section " << this->name << ":" << endl;
+  cout << endl << "Pool entries for section " << stringTable.name(this->name) << ":" << endl;
   cout << "|   Value   |   Location   |" << endl;
   // Todo: use chronological vector.
   for (itLit = poolEntriesLit.begin(); itLit != poolEntriesLit.end(); itLit++) {
     std::cout << itLit->first << "   " << itLit->second << std::endl;
   }
   for (itSym = poolEntriesSym.begin(); itSym != poolEntriesSym.end(); itSym++) {
-    std::cout << itSym->first << "   " << itSym->second << std::endl;
+    std::cout << stringTable.name(itSym->first) << "   " << itSym->second << std::endl;
   }
   cout << endl << endl;
 }
@@ -109,8 +115,8 @@ void Section::printContent(FILE* outputFile) {
     else if (i % 4 == 0) fprintf(outputFile, " ");
   }
 }
-void Section::printSection(FILE* outputFile) {
-  fprintf(outputFile, "#%s: \n", name.c_str());
+void Section::printSection(FILE* outputFile, const StringTable& names) {
+  fprintf(outputFile, "#%s: \n", names.name(name).c_str());
 
   //printPoolEntries();
   printContent(outputFile);
@@ -120,81 +126,64 @@ void Section::printSection(FILE* outputFile) {
 
 // Binary file support:
 void Section::bWrite(std::ofstream& file) {
-  uint len = name.length();
-  file.write((char*)&len, sizeof(uint));
-  file.write((char*)name.c_str(), len);
-
-  file.write((char*)&base, sizeof(uint));
-
-  len = content.size();
-  file.write((char*)&len, sizeof(uint));
-  for (char c : content) {
-    file.write((char*)&c, sizeof(char));
-  }
-
-  file.write((char*)&length, sizeof(uint));
-
-  uint mapLen = poolEntriesLit.size();
-  file.write((char*)&mapLen, sizeof(uint));
-  
+  bWriteUint(file, name);
+  bWriteUint(file, base);
+  bWriteBytes(file, content);
+  bWriteUint(file, length);
+
+  // Pool entries are written as blocks of (value, location) and (symName, location) pairs:
+  vector<uint> lits;
+  lits.reserve(2 * poolEntriesLit.size());
   for (unordered_map<int, uint>::iterator it = poolEntriesLit.begin(); it != poolEntriesLit.end(); it++) {
-    file.write((char*)&it->first, sizeof(int));
-    file.write((char*)&it->second, sizeof(uint));
+    lits.push_back(it->first);
+    lits.push_back(it->second);
   }
-
-  mapLen = poolEntriesSym.size();
-  file.write((char*)&mapLen, sizeof(uint));
-  for (unordered_map<string, uint>::iterator it = poolEntriesSym.begin(); it != poolEntriesSym.end(); it++) {
-    len = it->first.length();
-    file.write((char*)&len, sizeof(int));
-    file.write((char*)it->first.c_str(), len);
-
-    file.write((char*)&it->second, sizeof(uint));
-  }
-}
-void Section::bRead(std::ifstream& file) {
-  uint len;
-  file.read((char*)&len, sizeof(uint));
-
-  char* tmp = new char[len+1];
-  tmp[len] = '\0';
-  file.read((char*)tmp, len);
-  name = tmp;
-  delete tmp;
-
-  file.read((char*)&base, sizeof(uint));
-
-  file.read((char*)&len, sizeof(uint));
-  content.resize(len);
-  for (int i = 0; i < len; i++) {
-    file.read((char*)&content[i], sizeof(char));
+  bWriteUint(file, poolEntriesLit.size());
+  file.write((char*)lits.data(), lits.size() * sizeof(uint));
+
+  vector<uint> syms;
+  syms.reserve(2 * poolEntriesSym.size());
+  for (unordered_map<uint, uint>::iterator it = poolEntriesSym.begin(); it != poolEntriesSym.end(); it++) {
+    syms.push_back(it->first);
+    syms.push_back(it->second);
   }
+  bWriteUint(file, poolEntriesSym.size());
+  file.write((char*)syms.data(), syms.size() * sizeof(uint));
 
-  file.read((char*)&length, sizeof(uint));
-
-  uint mapLen;
-  file.read((char*)&mapLen, sizeof(uint));
+  bWriteUint(file, poolRefs.size());
+  file.write((char*)poolRefs.data(), poolRefs.size() * sizeof(uint));
+}
+void Section::bRead(std::ifstream& file, const vector<uint>& fileIds) {
+  name = bReadId(file, fileIds);
+  base = bReadUint(file);
+  bReadBytes(file, content);
+  length = bReadUint(file);
+
+  uint mapLen = bReadUint(file);
+  if (file.fail()) return;
+  vector<uint> lits(2 * mapLen);
+  file.read((char*)lits.data(), lits.size() * sizeof(uint));
+  poolEntriesLit.reserve(mapLen);
   for (uint i = 0; i < mapLen; i++) {
-    int key; uint value;
-    file.read((char*)&key, sizeof(int));
-    file.read((char*)&value, sizeof(uint));
-    poolEntriesLit.insert(make_pair(key, value));
+    poolEntriesLit.insert(make_pair((int)lits[2*i], lits[2*i + 1]));
   }
 
-  file.read((char*)&mapLen, sizeof(uint));
+  mapLen = bReadUint(file);
+  if (file.fail()) return;
+  vector<uint> syms(2 * mapLen);
+  file.read((char*)syms.data(), syms.size() * sizeof(uint));
+  if (file.fail()) return;
+  poolEntriesSym.reserve(mapLen);
   for (uint i = 0; i < mapLen; i++) {
-    uint len;
-    file.read((char*)&len, sizeof(uint));
-
-    char* tmp = new char[len+1];
-    tmp[len] = '\0';
-    file.read((char*)tmp, len);
-    string symName = tmp;
-    delete tmp;
-
-    uint value;
-    file.read((char*)&value, sizeof(uint));
-
-    poolEntriesSym.insert(make_pair(symName, value));
+    if (syms[2*i] >= fileIds.size()) {
+      file.setstate(ios::failbit);
+      return;
+    }
+    poolEntriesSym.insert(make_pair(fileIds[syms[2*i]], syms[2*i + 1]));
   }
+
+  mapLen = bReadUint(file);
+  if (file.fail()) return;
+  poolRefs.resize(mapLen);
+  file.read((char*)poolRefs.data(), poolRefs.size() * sizeof(uint));
 }
\ No newline at end of file
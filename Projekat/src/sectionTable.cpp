@@ -2,40 +2,46 @@
 
 
 // Fetches a section from the section table:
-Section* SectionTable::lookFor(string sectName) {
-  unordered_map<string, Section>::iterator it = sectionTable.find(sectName);
+Section* SectionTable::lookFor(uint sectName) {
+  unordered_map<uint, Section>::iterator it = sectionTable.find(sectName);
 
   if (it == sectionTable.end()) return nullptr;
   else return &it->second;
 }
 
 // Adds a section to the section table:
-void SectionTable::addSection(string sectName, Section section) {
-  sectionTable.insert(make_pair(sectName, section));
+void SectionTable::addSection(uint sectName, Section section) {
+  sectionTable.insert(make_pair(sectName, std::move(section)));
   sectionOrder.push_back(sectName);
 }
 
+// Removes a section from the section table:
+void SectionTable::removeSection(uint sectName) {
+  if (sectionTable.erase(sectName) == 0) return;
+  sectionOrder.erase(find(sectionOrder.begin(), sectionOrder.end(), sectName));
+}
+
 // Updates a section in the map by swapping it with the given updated object:
 void SectionTable::updateSection(Section section) {
-  sectionTable.at(section.getName()) = section;
+  sectionTable.at(section.getName()) = std::move(section);
 }
 
 
 // Fill each literalTables with values (locations of lits/syms) after first cycle (that's when the lenght of machine code is known)
 //  and initialize the size of content vector so that we can insert literals' values into the pool locations during second cycle.
 void SectionTable::finalizeLiteralsTables() {
-  for(unordered_map<string, Section>::iterator it = sectionTable.begin(); it != sectionTable.end(); it++) {
+  for(unordered_map<uint, Section>::iterator it = sectionTable.begin(); it != sectionTable.end(); it++) {
     it->second.finalizeLiteralsTable();
   }
 }
 
 
 // Printing:
-void SectionTable::printSectionTables(FILE* outputFile) {
-  for (string sectName : sectionOrder) {
-    unordered_map<string, Section>::iterator it = sectionTable.find(sectName);
+void SectionTable::printSectionTables(FILE* outputFile, const StringTable& names) {
+  for (uint sectName : sectionOrder) {
+    unordered_map<uint, Section>::iterator it = sectionTable.find(sectName);
     if (it->second.getContent().size() != 0) {
-      it->second.printSection(outputFile);  
+      it->second.printSection(outputFile, names);  
     }
   }
   fprintf(outputFile, "\n\n"); 
@@ -44,36 +50,24 @@ void SectionTable::printSectionTables(FILE* outputFile) {
 
 // Binary file support:
 void SectionTable::bWrite(std::ofstream& file) {
-  uint mapLen = sectionTable.size();
-  file.write((char*)&mapLen, sizeof(uint));
+  bWriteUint(file, sectionTable.size());
 
-  for (string sectName : sectionOrder) {
-    unordered_map<string, Section>::iterator it = sectionTable.find(sectName);
-    uint len = it->first.length();
-    file.write((char*)&len, sizeof(uint));
-    file.write((char*)it->first.c_str(), len);
-
-    it->second.bWrite(file);
+  for (uint sectName : sectionOrder) {
+    bWriteUint(file, sectName);
+    sectionTable.find(sectName)->second.bWrite(file);
   }
 }
-void SectionTable::bRead(std::ifstream& file) {
-  uint mapLen;
-  file.read((char*)&mapLen, sizeof(uint));
-
-  for (int i = 0; i < mapLen; i++) {
-    uint len;
-    file.read((char*)&len, sizeof(uint));
+void SectionTable::bRead(std::ifstream& file, const vector<uint>& fileIds) {
+  uint mapLen = bReadUint(file);
+  if (file.fail()) return;
 
-    char* tmp = new char[len+1];
-    tmp[len] = '\0';
-    file.read((char*)tmp, len);
-    string sectName = tmp;
-    delete tmp;
+  for (uint i = 0; i < mapLen; i++) {
+    uint sectName = bReadId(file, fileIds);
 
     Section section;
-    section.bRead(file);
+    section.bRead(file, fileIds);
 
-    sectionTable.insert(make_pair(sectName, section));
+    sectionTable.insert(make_pair(sectName, std::move(section)));
     sectionOrder.push_back(sectName);
   }
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "../inc/stringTable.hpp"
+
+
+StringTable stringTable;
+
+
+// Constructors:
+StringTable::StringTable() {
+  intern("UND");
+  intern("TBD");
+  intern("EXT");
+}
+
+
+// Returns the id of the given name, adding it if it's seen for the first time:
+uint StringTable::intern(const string& name) {
+  unordered_map<string, uint>::iterator it = ids.find(name);
+  if (it != ids.end()) return it->second;
+
+  uint id = names.size();
+  names.push_back(name);
+  ids.insert(make_pair(name, id));
+  return id;
+}
+
+
+// Interns names read from a file, fileIds gets the id in this table of every one of them:
+void StringTable::intern(const vector<string>& fileNames, vector<uint>& fileIds) {
+  fileIds.clear();
+  fileIds.reserve(fileNames.size());
+  for (const string& s : fileNames) {
+    fileIds.push_back(intern(s));
+  }
+}
+
+
+// Binary file support:
+void StringTable::bWrite(std::ofstream& file) {
+  bWriteUint(file, names.size());
+  for (const string& s : names) {
+    bWriteString(file, s);
+  }
+}
+void StringTable::bReadNames(std::ifstream& file, vector<string>& fileNames) {
+  uint len = bReadUint(file);
+  fileNames.clear();
+  if (file.fail()) return;
+
+  for (uint i = 0; i < len && !file.fail(); i++) {
+    fileNames.push_back(string());
+    bReadString(file, fileNames.back());
+  }
+}
+
+// Reads a name id written to a file and returns its id in stringTable:
+uint bReadId(std::ifstream& file, const vector<uint>& fileIds) {
+  uint id = bReadUint(file);
+  if (id < fileIds.size()) return fileIds[id];
+
+  file.setstate(ios::failbit);
+  return undId;
+}
@@ -2,7 +2,7 @@
 
 
 // Creates a new SymbolEntry in the SymbolTable:
-void SymbolTable::createSymbolEntry(string name, string section, uint value, char type) {
+void SymbolTable::createSymbolEntry(uint name, uint section, uint value, char type) {
   SymbolTableEntry entry(section, value, type);
 
   symbolTable.insert(make_pair(name, entry));
@@ -10,20 +10,20 @@ void SymbolTable::createSymbolEntry(string name, string section, uint value, cha
 
 
 // Fetches a SymbolTableEntry:
-SymbolTableEntry* SymbolTable::lookFor(string symName) {
-  unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.find(symName);
+SymbolTableEntry* SymbolTable::lookFor(uint symName) {
+  unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.find(symName);
   if (it == symbolTable.end()) return nullptr;
   else return &it->second;
 }
 
 // Checks if there are undefined non-extern symbol after the first assembler cycle:
-int SymbolTable::validateSymbolTable() {
+int SymbolTable::validateSymbolTable(const StringTable& names) {
   bool err = false;
 
-  for (unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
     SymbolTableEntry entry = it->second;
-    if (entry.getSection() == "TBD") {
-      fprintf(stderr, "\nERROR: usage of an undefined non-extern symbol: %s\n", it->first.c_str());
+    if (entry.getSection() == tbdId) {
+      fprintf(stderr, "\nERROR: usage of an undefined non-extern symbol: %s\n", names.name(it->first).c_str());
       err = true; // Doesn't immediately return -1 so that it can print all undefined symbols, not just the first one.
     }
   } 
@@ -34,13 +34,13 @@ int SymbolTable::validateSymbolTable() {
 
 
 // Funs for printing:
-void SymbolTable::printSymbolTable(FILE* outputFile) {
+void SymbolTable::printSymbolTable(FILE* outputFile, const StringTable& names) {
   fprintf(outputFile, "#SymbolTable\n");
   fprintf(outputFile, "|      SymName      |       SecName      |  Value  | Type |\n");
 
-  for (unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
     fprintf(outputFile, "%-20s %-20s %-10d %c\n", 
-    it->first.c_str(), it->second.getSection().c_str(), it->second.getValue(), it->second.getType());
+    names.name(it->first).c_str(), names.name(it->second.getSection()).c_str(), it->second.getValue(), it->second.getType());
   }
   fprintf(outputFile, "\n\n");
 }
@@ -48,33 +48,23 @@ void SymbolTable::printSymbolTable(FILE* outputFile) {
 
 // Binary file support:
 void SymbolTable::bWrite(std::ofstream& file) {
-  uint mapLen = symbolTable.size();
-  file.write((char*)&mapLen, sizeof(uint));
-
-  for (unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
-    uint len = it->first.length();
-    file.write((char*)&len, sizeof(uint));
-    file.write((char*)it->first.c_str(), len);
+  bWriteUint(file, symbolTable.size());
 
+  for (unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
+    bWriteUint(file, it->first);
     it->second.bWrite(file);
   }
 }
-void SymbolTable::bRead(std::ifstream& file) {
-  uint mapLen;
-  file.read((char*)&mapLen, sizeof(uint));
+void SymbolTable::bRead(std::ifstream& file, const vector<uint>& fileIds) {
+  uint mapLen = bReadUint(file);
+  if (file.fail()) return;
+  symbolTable.reserve(mapLen);
 
   for (uint i = 0; i < mapLen; i++) {
-    uint len;
-    file.read((char*)&len, sizeof(uint));
-
-    char* tmp = new char[len+1];
-    tmp[len] = '\0';
-    file.read((char*)tmp, len);
-    string symName = tmp;
-    delete tmp;
+    uint symName = bReadId(file, fileIds);
 
     SymbolTableEntry ste;
-    ste.bRead(file);
+    ste.bRead(file, fileIds);
 
     symbolTable.insert(make_pair(symName, ste));
   }
@@ -84,21 +74,37 @@ void SymbolTable::bRead(std::ifstream& file) {
 /// ---- Funs needed for linker: ----
 
 // Increases values of SymbolTableEntries that belong to the given section by section's base address:
-void SymbolTable::updateLocalSymbolsValuesForSection(string sectName, uint sectBase) {
-  for (unordered_map<string, SymbolTableEntry>::iterator i = symbolTable.begin(); i != symbolTable.end(); i++) {
-    if (strcmp(i->second.getSection().c_str(), sectName.c_str()) == 0) {
+void SymbolTable::updateLocalSymbolsValuesForSection(uint sectName, uint sectBase) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator i = symbolTable.begin(); i != symbolTable.end(); i++) {
+    if (i->second.getSection() == sectName) {
       i->second.setValue(i->second.getValue() + sectBase);
     }
   }
 }
 
+// Removes SymbolTableEntries that belong to the given section: (for sections '--gc-sections' drops)
+void SymbolTable::removeSymbolsOfSection(uint sectName) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator i = symbolTable.begin(); i != symbolTable.end(); ) {
+    if (i->second.getSection() == sectName) i = symbolTable.erase(i);
+    else i++;
+  }
+}
+
+// Removes extern symbols that aren't among the used ones: (after '--gc-sections' drops the sections that used them)
+void SymbolTable::removeUnusedExterns(const unordered_set<uint>& used) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator i = symbolTable.begin(); i != symbolTable.end(); ) {
+    if (i->second.getType() == 'e' && used.find(i->first) == used.end()) i = symbolTable.erase(i);
+    else i++;
+  }
+}
+
 // Move global symbols from this SymbolTable to linker's resulting SymbolTable:
 int SymbolTable::exportGlobalSymbols(SymbolTable& resSymbolTable) {
-  for (unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
     if (it->second.getType() != 'g') continue;
     
     if (resSymbolTable.lookFor(it->first)) {
-      fprintf(stderr, "Multiple global definitions of symbol %s.\n", it->first.c_str());
+      fprintf(stderr, "Multiple global definitions of symbol %s.\n", stringTable.name(it->first).c_str());
       return -1;
     }
 
@@ -109,12 +115,17 @@ int SymbolTable::exportGlobalSymbols(SymbolTable& resSymbolTable) {
 }
 
 // Checks if every extern symbol in this SymbolTable is defined in the linker's resulting SymbolTable:
-int SymbolTable::checkForUndefinedExtern(SymbolTable& resSymbolTable) {
-  for (unordered_map<string, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
+//  (if undefined is given, undefined extern symbols are added to it instead of being an error)
+int SymbolTable::checkForUndefinedExtern(SymbolTable& resSymbolTable, vector<uint>* undefined) {
+  for (unordered_map<uint, SymbolTableEntry>::iterator it = symbolTable.begin(); it != symbolTable.end(); it++) {
     if (it->second.getType() != 'e') continue;
   
     if (!resSymbolTable.lookFor(it->first)) {
-      fprintf(stderr, "Usage of non-defined extern symbol %s\n", it->first.c_str());
+      if (undefined) {
+        undefined->push_back(it->first);
+        continue;
+      }
+      fprintf(stderr, "Usage of non-defined extern symbol %s\n", stringTable.name(it->first).c_str());
       return -1;
     }
   }
@@ -2,12 +2,7 @@ ASSEMBLER=../misc/asembler
 LINKER=../misc/linker
 EMULATOR=../misc/emulator
 
-${ASSEMBLER} -o main.o main.s
-${ASSEMBLER} -o math.o math.s
-${ASSEMBLER} -o handler.o handler.s
-${ASSEMBLER} -o isr_timer.o isr_timer.s
-${ASSEMBLER} -o isr_terminal.o isr_terminal.s
-${ASSEMBLER} -o isr_software.o isr_software.s
+${ASSEMBLER} -j 4 main.s math.s handler.s isr_timer.s isr_terminal.s isr_software.s
 ${LINKER} -hex \
   -place=my_code@0x40000000 -place=math@0xF0000000 \
   -o program.hex \